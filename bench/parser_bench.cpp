@@ -0,0 +1,725 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+#include <new>
+
+#include <parser/parser.h>
+#include <parser/dual.h>
+#include <parser/static_expression.h>
+
+// Count of heap allocations made through operator new
+static size_t s_HeapAllocationCount = 0;
+
+// Every form of operator new and delete is replaced, so each allocation is counted and freed by the same pair
+static void* Allocate(size_t size, size_t alignment) noexcept {
+    ++s_HeapAllocationCount;
+    size = size ? size : 1;
+    if (alignment <= alignof(std::max_align_t)) {
+        return malloc(size);
+    }
+    return aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+static void* AllocateOrThrow(size_t size, size_t alignment) {
+    if (void* memory = Allocate(size, alignment)) {
+        return memory;
+    }
+#ifdef __cpp_exceptions
+    throw std::bad_alloc();
+#else
+    abort();
+#endif
+}
+
+static void Deallocate(void* memory) noexcept { free(memory); }
+
+void* operator new(size_t size) { return AllocateOrThrow(size, 0); }
+void* operator new[](size_t size) { return AllocateOrThrow(size, 0); }
+void* operator new(size_t size, std::align_val_t alignment) { return AllocateOrThrow(size, (size_t)alignment); }
+void* operator new[](size_t size, std::align_val_t alignment) { return AllocateOrThrow(size, (size_t)alignment); }
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return Allocate(size, 0); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return Allocate(size, 0); }
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return Allocate(size, (size_t)alignment);
+}
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return Allocate(size, (size_t)alignment);
+}
+
+void operator delete(void* memory) noexcept { Deallocate(memory); }
+void operator delete[](void* memory) noexcept { Deallocate(memory); }
+void operator delete(void* memory, size_t) noexcept { Deallocate(memory); }
+void operator delete[](void* memory, size_t) noexcept { Deallocate(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { Deallocate(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { Deallocate(memory); }
+void operator delete(void* memory, size_t, std::align_val_t) noexcept { Deallocate(memory); }
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept { Deallocate(memory); }
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept { Deallocate(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { Deallocate(memory); }
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept { Deallocate(memory); }
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept { Deallocate(memory); }
+
+namespace {
+    using Parser = core::Parser<>;
+
+    struct Corpus {
+    public:
+        const char*              name;
+        std::vector<std::string> expressions;
+    };
+
+    // Deterministic generator (std::mt19937 sequence is fixed by the standard)
+    class CorpusGenerator {
+    public:
+        explicit CorpusGenerator(uint32_t seed) : m_random(seed) {}
+
+    public:
+        // 3-9 operands of arithmetic with variables
+        Corpus Short(size_t count) {
+            Corpus corpus{ "short", {} };
+            for (size_t i = 0; i < count; ++i) {
+                std::string e = _Operand();
+                for (size_t n = _Next(2, 8); n > 0; --n) {
+                    e += _Operator();
+                    e += _Operand();
+                }
+                corpus.expressions.push_back(std::move(e));
+            }
+            return corpus;
+        }
+
+        // Parentheses nested 32-128 levels deep
+        Corpus Deep(size_t count) {
+            Corpus corpus{ "deep", {} };
+            for (size_t i = 0; i < count; ++i) {
+                std::string e = _Operand();
+                for (size_t n = _Next(32, 128); n > 0; --n) {
+                    e = _Operand() + _Operator() + "(" + e + ")";
+                }
+                corpus.expressions.push_back(std::move(e));
+            }
+            return corpus;
+        }
+
+        // Machine-generated nesting 2048-8192 levels deep: parentheses, unary minus and right operands
+        Corpus Nested(size_t count) {
+            Corpus corpus{ "nested", {} };
+            for (size_t i = 0; i < count; ++i) {
+                std::string e;
+                size_t      closeCount = 0;
+                for (size_t n = _Next(2048, 8192); n > 0; --n) {
+                    switch (_Next(0, 2)) {
+                        case 0:  e += "(";                            ++closeCount; break;
+                        case 1:  e += "-";                                          break;
+                        default: e += _Operand() + _Operator() + "("; ++closeCount; break;
+                    }
+                }
+                e += _Operand();
+                e.append(closeCount, ')');
+                corpus.expressions.push_back(std::move(e));
+            }
+            return corpus;
+        }
+
+        // avg with 64-512 arguments
+        Corpus LongAvg(size_t count) {
+            Corpus corpus{ "long_avg", {} };
+            for (size_t i = 0; i < count; ++i) {
+                std::string e = "avg(" + _Operand();
+                for (size_t n = _Next(63, 511); n > 0; --n) {
+                    e += ",";
+                    e += _Operand();
+                }
+                e += ")";
+                corpus.expressions.push_back(std::move(e));
+            }
+            return corpus;
+        }
+
+        // sum, min, max or stddev with 64-512 arguments
+        Corpus Aggregates(size_t count) {
+            static const char* s_functions[] = { "sum", "min", "max", "stddev" };
+
+            Corpus corpus{ "aggregates", {} };
+            for (size_t i = 0; i < count; ++i) {
+                std::string e = std::string(s_functions[_Next(0, 3)]) + "(" + _Operand();
+                for (size_t n = _Next(63, 511); n > 0; --n) {
+                    e += ",";
+                    e += _Operand();
+                }
+                e += ")";
+                corpus.expressions.push_back(std::move(e));
+            }
+            return corpus;
+        }
+
+        // Calls of builtin functions nested 2-8 levels deep
+        Corpus FunctionHeavy(size_t count) {
+            static const char* s_functions[] = { "sqrt", "sin", "cos", "tan", "cot", "ln" };
+
+            Corpus corpus{ "function_heavy", {} };
+            for (size_t i = 0; i < count; ++i) {
+                std::string e = _Operand();
+                for (size_t n = _Next(2, 8); n > 0; --n) {
+                    if (_Next(0, 3) == 0) {
+                        e = "pow(" + e + "," + _Operand() + ")";
+                    }
+                    else {
+                        e = std::string(s_functions[_Next(0, 5)]) + "(" + e + ")" + _Operator() + _Operand();
+                    }
+                }
+                corpus.expressions.push_back(std::move(e));
+            }
+            return corpus;
+        }
+
+        // Only literals and named constants, folded at compile time
+        Corpus ConstantHeavy(size_t count) {
+            Corpus corpus{ "constant_heavy", {} };
+            for (size_t i = 0; i < count; ++i) {
+                std::string e = _Constant();
+                for (size_t n = _Next(8, 32); n > 0; --n) {
+                    e += _Operator();
+                    e += _Constant();
+                }
+                corpus.expressions.push_back(std::move(e));
+            }
+            return corpus;
+        }
+
+    private:
+        size_t _Next(size_t min, size_t max) {
+            return min + m_random() % (max - min + 1);
+        }
+
+        std::string _Operator() {
+            static const char* s_operators[] = { "+", "-", "*", "/" };
+            return s_operators[_Next(0, 3)];
+        }
+
+        std::string _Constant() {
+            switch (_Next(0, 3)) {
+                case 0:  return "pi";
+                case 1:  return "e";
+                case 2:  return std::to_string(_Next(1, 1000));
+                default: return std::to_string(_Next(1, 1000)) + "." + std::to_string(_Next(0, 999));
+            }
+        }
+
+        std::string _Operand() {
+            static const char* s_variables[] = { "x", "y", "z" };
+            return _Next(0, 2) == 0 ? s_variables[_Next(0, 2)] : _Constant();
+        }
+
+    private:
+        std::mt19937 m_random;
+    };
+
+    // Fixed expressions around signed zeros, NaN, infinities and the lanes of sum and avg
+    Corpus EdgeCases() {
+        static const char* s_expressions[] = {
+            "x", "-x", "-(-x)", "x+0", "x-0", "0+x", "0-x", "-0+x", "x+(-0)", "x*0", "0*x", "x*(-0)", "-0*x",
+            "x*1", "1*x", "x/1", "x/y", "x/0", "0/x", "-0/x", "0/0+x", "x-x", "x*y-y*x", "x^y", "pow(x,y)", "x^0",
+            "sqrt(x)", "ln(x)", "sin(x)+cos(y)", "tan(x)*cot(y)", "2^x^y", "-x^2", "(x+y)*(x-y)-z",
+            "sum(x)", "avg(x)", "sum(x,-0)", "sum(-0,-0,x)", "avg(x,-0,y)", "sum(x,y,z)", "avg(x,y,z)",
+            "sum(x,-x,y,-y)", "avg(x*y,y*z,z*x,0/0)", "sum(0,-0,x,-0,y,-0,z,-0,1e308,1e308)",
+            "-0", "1/-0", "0*-1", "-(1-1)*x", "x/(0*-2)"
+        };
+
+        static const char* s_operands[] = { "x", "-y", "z*x", "-0", "1e308", "0.1" };
+
+        Corpus corpus{ "edge_cases", {} };
+        for (const char* expression : s_expressions) {
+            corpus.expressions.emplace_back(expression);
+        }
+
+        // argument counts at lane and block boundaries of the reduction
+        for (size_t argCount : { 2, 7, 8, 9, 15, 16, 17, 64, 127, 128, 129 }) {
+            for (const char* function : { "sum(", "avg(" }) {
+                std::string e = function;
+                for (size_t i = 0; i < argCount; ++i) {
+                    e += i > 0 ? "," : "";
+                    e += s_operands[i % (sizeof(s_operands) / sizeof(*s_operands))];
+                }
+                e += ")";
+                corpus.expressions.push_back(std::move(e));
+            }
+        }
+        return corpus;
+    }
+
+    class Stopwatch {
+    public:
+        Stopwatch() :
+        m_start(std::chrono::steady_clock::now()),
+        m_allocationCount(s_HeapAllocationCount + core::Arena::GetTotalAllocationCount()) {}
+
+    public:
+        // One machine-readable line per stage
+        void Report(const char* corpus, const char* stage, size_t expressionCount) const {
+            double nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - m_start).count();
+            size_t allocations = s_HeapAllocationCount + core::Arena::GetTotalAllocationCount() - m_allocationCount;
+
+            printf(
+                "%s\t%s\t%zu\t%.1f\t%.2f\t%.0f\n",
+                corpus,
+                stage,
+                expressionCount,
+                nanoseconds / expressionCount,
+                (double)allocations / expressionCount,
+                expressionCount / (nanoseconds * 1e-9)
+            );
+        }
+
+    private:
+        std::chrono::steady_clock::time_point m_start;
+        size_t                                m_allocationCount;
+    };
+
+    void RunCorpus(const Parser& parser, const Corpus& corpus, size_t repeatCount) {
+        const double variables[] = { 1.5, -2.25, 3.0 };
+
+        size_t count = corpus.expressions.size() * repeatCount;
+        core::Arena arena(1 << 20);
+
+        std::vector<Parser::TokenStream>                                           tokens(count);
+        std::vector<Parser::Result<Parser::CompiledExpression, Parser::ErrorInfo>> compiled(count);
+
+        volatile size_t invalidCount = 0;
+        volatile double sink         = 0;
+
+        {
+            Stopwatch stopwatch;
+            for (size_t i = 0; i < count; ++i) {
+                parser.Tokenize(corpus.expressions[i % corpus.expressions.size()].c_str(), arena, tokens[i]);
+            }
+            stopwatch.Report(corpus.name, "tokenize", count);
+        }
+        {
+            Stopwatch stopwatch;
+            for (size_t i = 0; i < count; ++i) {
+                parser.Specify(tokens[i]);
+            }
+            stopwatch.Report(corpus.name, "specify", count);
+        }
+        {
+            Stopwatch stopwatch;
+            for (size_t i = 0; i < count; ++i) {
+                invalidCount += parser.Validate(tokens[i]) != Parser::ExpressionError::IS_VALID;
+            }
+            stopwatch.Report(corpus.name, "validate", count);
+        }
+        {
+            Stopwatch stopwatch;
+            for (size_t i = 0; i < count; ++i) {
+                compiled[i] = parser.Build(tokens[i]);
+            }
+            stopwatch.Report(corpus.name, "build", count);
+        }
+        {
+            Stopwatch stopwatch;
+            for (size_t i = 0; i < count; ++i) {
+                if (compiled[i].HasValue()) {
+                    sink = sink + compiled[i].Get().Evaluate(variables);
+                }
+            }
+            stopwatch.Report(corpus.name, "evaluate", count);
+        }
+        {
+            Stopwatch stopwatch;
+            for (size_t i = 0; i < count; ++i) {
+                if (compiled[i].HasValue()) {
+                    sink = sink + compiled[i].Get().EvaluateTree(variables);
+                }
+            }
+            stopwatch.Report(corpus.name, "evaluate_tree", count);
+        }
+
+        arena.Reset();
+        {
+            Stopwatch stopwatch;
+            for (size_t i = 0; i < count; ++i) {
+                invalidCount += parser.Scan(corpus.expressions[i % corpus.expressions.size()].c_str(), arena, tokens[i]) !=
+                    Parser::ExpressionError::IS_VALID;
+            }
+            stopwatch.Report(corpus.name, "scan", count);
+        }
+
+        tokens.clear();
+        compiled.clear();
+        arena.Reset();
+
+        {
+            Stopwatch stopwatch;
+            for (size_t i = 0; i < count; ++i) {
+                auto result = parser.Compile(corpus.expressions[i % corpus.expressions.size()].c_str());
+                if (result.HasValue()) {
+                    sink = sink + result.Get().Evaluate(variables);
+                }
+            }
+            stopwatch.Report(corpus.name, "compile_evaluate", count);
+        }
+
+        if (invalidCount > 0) {
+            fprintf(stderr, "%s: %zu invalid expressions\n", corpus.name, (size_t)invalidCount);
+        }
+    }
+
+    // Parser with real type of "Traits" and variables x, y, z
+    template <typename Traits>
+    core::Parser<Traits> MakeParser() {
+        core::Parser<Traits> parser;
+        parser.DeclareVariable("x");
+        parser.DeclareVariable("y");
+        parser.DeclareVariable("z");
+        return parser;
+    }
+
+    // Error against long double evaluation and speed of one real type
+    template <typename Traits>
+    void RunPrecision(const char* type, const Corpus& corpus, size_t repeatCount) {
+        using Real = typename Traits::Real;
+
+        static constexpr size_t s_RowCount = 256;
+
+        const auto reference = MakeParser<core::Parser<>::LongDoubleTraits>();
+        const auto parser    = MakeParser<Traits>();
+
+        const long double referenceVariables[] = { 1.5L, -2.25L, 3.0L };
+        const Real        variables[]          = { Real(1.5), Real(-2.25), Real(3.0) };
+
+        std::vector<Real> columns[3];
+        for (size_t row = 0; row < s_RowCount; ++row) {
+            columns[0].push_back(Real(1.5 + row * 0.01));
+            columns[1].push_back(Real(-2.25 + row * 0.02));
+            columns[2].push_back(Real(3.0 - row * 0.005));
+        }
+        const Real* columnPointers[] = { columns[0].data(), columns[1].data(), columns[2].data() };
+
+        std::vector<typename core::Parser<Traits>::CompiledExpression> compiled;
+        double maxError   = 0;
+        double errorSum   = 0;
+        size_t errorCount = 0;
+
+        for (const std::string& expression : corpus.expressions) {
+            auto result         = parser.Compile(expression.c_str());
+            auto referenceValue = reference.Compile(expression.c_str());
+            if (!result.HasValue() || !referenceValue.HasValue()) {
+                continue;
+            }
+            compiled.push_back(result.Get());
+
+            long double expected = referenceValue.Get().Evaluate(referenceVariables);
+            long double actual   = (long double)result.Get().Evaluate(variables);
+            if (!std::isfinite(expected) || expected == 0) {
+                continue;
+            }
+
+            // Overflow of a narrower type counts as the whole value lost
+            double error = std::isfinite(actual) ? (double)std::fabs((actual - expected) / expected) : 1.0;
+            maxError = std::max(maxError, error);
+            errorSum += error;
+            ++errorCount;
+        }
+
+        volatile Real  sink = 0;
+        std::vector<Real> results(s_RowCount);
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < repeatCount; ++i) {
+            for (const auto& expression : compiled) {
+                sink = sink + expression.Evaluate(variables);
+            }
+        }
+        double evaluateNanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < repeatCount; ++i) {
+            for (const auto& expression : compiled) {
+                expression.EvaluateBatch(columnPointers, s_RowCount, results.data());
+                sink = sink + results[0];
+            }
+        }
+        double batchNanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        size_t evaluationCount = std::max<size_t>(compiled.size() * repeatCount, 1);
+        printf(
+            "%s\t%s\t%.3g\t%.3g\t%.1f\t%.2f\n",
+            corpus.name,
+            type,
+            maxError,
+            errorCount ? errorSum / errorCount : 0.0,
+            evaluateNanoseconds / evaluationCount,
+            batchNanoseconds / (evaluationCount * s_RowCount)
+        );
+    }
+
+    // Native code, interpreter and expression tree must give the same bits (sign of zero included) for every
+    // combination of the variable values, returns count of mismatches. NaN only has to be NaN everywhere: sign and
+    // payload of NaN result aren't specified, compiler may swap operands of the interpreter's additions
+    size_t CheckNative(const Corpus& corpus) {
+        static const double s_values[] = {
+            0.0, -0.0, 1.5, -2.25, 3.0, 1e308, std::numeric_limits<double>::infinity(),
+            -std::numeric_limits<double>::infinity(), std::numeric_limits<double>::quiet_NaN()
+        };
+        static constexpr size_t s_ValueCount = sizeof(s_values) / sizeof(*s_values);
+
+        Parser native(Parser::DefaultTraits(), Parser::KEEP_TREE | Parser::ENABLE_JIT);
+        Parser interpreter(Parser::DefaultTraits(), Parser::KEEP_TREE);
+        for (Parser* parser : { &native, &interpreter }) {
+            parser->DeclareVariable("x");
+            parser->DeclareVariable("y");
+            parser->DeclareVariable("z");
+        }
+
+        auto isSame = [](double a, double b) { return (a != a && b != b) || memcmp(&a, &b, sizeof(double)) == 0; };
+
+        size_t nativeCount     = 0;
+        size_t evaluationCount = 0;
+        size_t mismatchCount   = 0;
+
+        for (const std::string& expression : corpus.expressions) {
+            auto nativeResult      = native.Compile(expression.c_str());
+            auto interpreterResult = interpreter.Compile(expression.c_str());
+            if (!nativeResult.HasValue() || !interpreterResult.HasValue()) {
+                continue;
+            }
+
+            core::JitFunction::Function function = nativeResult.Get().GetNativeFunction();
+            if (!function) {
+                continue;
+            }
+            ++nativeCount;
+
+            const Parser::CompiledExpression& compiled = interpreterResult.Get();
+            for (size_t i = 0; i < s_ValueCount * s_ValueCount * s_ValueCount; ++i) {
+                const double variables[] = {
+                    s_values[i % s_ValueCount], s_values[i / s_ValueCount % s_ValueCount], s_values[i / s_ValueCount / s_ValueCount]
+                };
+
+                double nativeValue      = function(variables);
+                double interpretedValue = compiled.Evaluate(variables);
+                double treeValue        = compiled.EvaluateTree(variables);
+                ++evaluationCount;
+
+                if (!isSame(nativeValue, interpretedValue) || !isSame(nativeValue, treeValue)) {
+                    if (mismatchCount++ < 10) {
+                        fprintf(
+                            stderr, "%s: %s at (%g, %g, %g): native %.17g, interpreter %.17g, tree %.17g\n",
+                            corpus.name, expression.c_str(), variables[0], variables[1], variables[2],
+                            nativeValue, interpretedValue, treeValue
+                        );
+                    }
+                }
+            }
+        }
+
+        printf("%s\t%zu\t%zu\t%zu\t%zu\n", corpus.name, corpus.expressions.size(), nativeCount, evaluationCount, mismatchCount);
+        return mismatchCount;
+    }
+
+    // Value and derivatives of the aggregates by Parser<DualTraits<2>> (forward mode) against value and reverse-mode
+    // gradient of Parser<>, returns count of mismatches
+    size_t CheckDual() {
+        using DualParser = core::Parser<core::DualTraits<2>>;
+        using Dual       = core::Dual<2>;
+
+        static const double s_points[][2] = { { 3.0, -2.0 }, { -2.5, -2.0 }, { 0.5, 4.0 } };
+
+        std::vector<std::string> expressions = {
+            "min(x, 5)", "max(-x, -5)", "min(x, y, 2)", "max(x*y, y, -1)", "min(x, 5)*max(y, -5)",
+            "sum(x, y, x*y)", "avg(x, y, 3)", "stddev(x, y, 1)"
+        };
+
+        // more than REDUCTION_BLOCK_SIZE arguments, so the reduction is split
+        for (const char* function : { "min(", "max(" }) {
+            std::string e = function;
+            for (int i = 0; i < 300; ++i) {
+                e += i == 150 ? "x*y," : std::to_string(i % 7 - 3) + ",";
+            }
+            e += "y)";
+            expressions.push_back(std::move(e));
+        }
+
+        Parser     parser;
+        DualParser dualParser;
+        parser.DeclareVariable("x");
+        parser.DeclareVariable("y");
+        dualParser.DeclareVariable("x");
+        dualParser.DeclareVariable("y");
+
+        auto isClose = [](double a, double b) { return std::fabs(a - b) <= 1e-12 * std::max(1.0, std::fabs(b)); };
+
+        size_t evaluationCount = 0;
+        size_t mismatchCount   = 0;
+
+        for (const std::string& expression : expressions) {
+            auto result     = parser.Compile(expression.c_str());
+            auto dualResult = dualParser.Compile(expression.c_str());
+            if (!result.HasValue() || !dualResult.HasValue()) {
+                fprintf(stderr, "dual: %s isn't compiled\n", expression.c_str());
+                ++mismatchCount;
+                continue;
+            }
+
+            for (const double* point : s_points) {
+                const Dual dualVariables[] = { Dual::Variable(point[0], 0), Dual::Variable(point[1], 1) };
+
+                double gradient[2] = {};
+                double value       = result.Get().EvaluateGradient(point, gradient);
+                Dual   dualValue   = dualResult.Get().Evaluate(dualVariables);
+                ++evaluationCount;
+
+                if (!isClose(dualValue.value, value) || !isClose(dualValue.derivatives[0], gradient[0]) ||
+                    !isClose(dualValue.derivatives[1], gradient[1])) {
+                    fprintf(
+                        stderr, "dual: %.40s at (%g, %g): %g (%g, %g), expected %g (%g, %g)\n",
+                        expression.c_str(), point[0], point[1], dualValue.value, dualValue.derivatives[0],
+                        dualValue.derivatives[1], value, gradient[0], gradient[1]
+                    );
+                    ++mismatchCount;
+                }
+            }
+        }
+
+        printf("dual\t%zu\t0\t%zu\t%zu\n", expressions.size(), evaluationCount, mismatchCount);
+        return mismatchCount;
+    }
+
+    // Signed zeros of the integer subexpressions against IEEE 754 (by Parser and static expression), returns count of
+    // mismatches. Negative zero has to stay Real, when integer operations are folded
+    size_t CheckSignedZeros() {
+        static constexpr double s_Infinity = std::numeric_limits<double>::infinity();
+
+        Parser parser;
+
+        size_t expressionCount = 0;
+        size_t mismatchCount   = 0;
+
+        auto check = [&](const char* expression, double staticValue, double expected) {
+            ++expressionCount;
+
+            auto   result = parser.Compile(expression);
+            double value  = result.HasValue() ? result.Get().Evaluate() : std::numeric_limits<double>::quiet_NaN();
+            if (memcmp(&value, &expected, sizeof(double)) != 0 || memcmp(&staticValue, &expected, sizeof(double)) != 0) {
+                fprintf(stderr, "signed zeros: %s: %g, static %g, expected %g\n", expression, value, staticValue, expected);
+                ++mismatchCount;
+            }
+        };
+
+        check("-0", PARSER_STATIC_EXPRESSION("-0")(), -0.0);
+        check("1/-0", PARSER_STATIC_EXPRESSION("1/-0")(), -s_Infinity);
+        check("0*-1", PARSER_STATIC_EXPRESSION("0*-1")(), -0.0);
+        check("-1*0", PARSER_STATIC_EXPRESSION("-1*0")(), -0.0);
+        check("-(2-2)", PARSER_STATIC_EXPRESSION("-(2-2)")(), -0.0);
+        check("1/((1-1)*-3)", PARSER_STATIC_EXPRESSION("1/((1-1)*-3)")(), -s_Infinity);
+        check("-0*-1", PARSER_STATIC_EXPRESSION("-0*-1")(), 0.0);
+        check("0*1-0", PARSER_STATIC_EXPRESSION("0*1-0")(), 0.0);
+
+        printf("signed_zeros\t%zu\t0\t%zu\t%zu\n", expressionCount, expressionCount, mismatchCount);
+        return mismatchCount;
+    }
+
+    // Literals are folded at compile time only when the conversion is exact
+    static_assert(PARSER_STATIC_EXPRESSION("9007199254740.992")() == 9007199254740.992, "mantissa 2^53 is exact");
+    static_assert(PARSER_STATIC_EXPRESSION("0.1 * 3")() == 0.1 * 3, "folded literals are correctly rounded");
+
+    // Static expressions against Parser (the same bits), returns count of mismatches. Mantissa of the literals
+    // doesn't fit double, so they are converted at runtime as in Parser
+    size_t CheckStatic() {
+        Parser parser;
+
+        size_t expressionCount = 0;
+        size_t mismatchCount   = 0;
+
+        auto check = [&](const char* expression, double staticValue) {
+            ++expressionCount;
+
+            auto   result = parser.Compile(expression);
+            double value  = result.HasValue() ? result.Get().Evaluate() : std::numeric_limits<double>::quiet_NaN();
+            if (memcmp(&value, &staticValue, sizeof(double)) != 0) {
+                fprintf(stderr, "static: %s: %.17g, expected %.17g\n", expression, staticValue, value);
+                ++mismatchCount;
+            }
+        };
+
+        check("90071992547409.93", PARSER_STATIC_EXPRESSION("90071992547409.93")());
+        check("9007199254740.993", PARSER_STATIC_EXPRESSION("9007199254740.993")());
+        check("0.18014398509481985", PARSER_STATIC_EXPRESSION("0.18014398509481985")());
+        check("1.0000000000000001", PARSER_STATIC_EXPRESSION("1.0000000000000001")());
+
+        printf("static\t%zu\t0\t%zu\t%zu\n", expressionCount, expressionCount, mismatchCount);
+        return mismatchCount;
+    }
+}
+
+// parser_bench [repeat count] [seed]
+// parser_bench --check [seed] (exit code is 1, if any check fails)
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "--check") == 0) {
+        CorpusGenerator generator(argc > 2 ? (uint32_t)strtoul(argv[2], nullptr, 10) : 1);
+        const Corpus corpora[] = {
+            EdgeCases(),
+            generator.Short(1000),
+            generator.Deep(100),
+            generator.LongAvg(100),
+            generator.FunctionHeavy(1000),
+            generator.ConstantHeavy(1000),
+            generator.Aggregates(100)
+        };
+
+        size_t mismatchCount = 0;
+
+        printf("corpus\texpressions\tnative\tevaluations\tmismatches\n");
+        for (const Corpus& corpus : corpora) {
+            mismatchCount += CheckNative(corpus);
+        }
+        mismatchCount += CheckDual();
+        mismatchCount += CheckSignedZeros();
+        mismatchCount += CheckStatic();
+        return mismatchCount > 0;
+    }
+
+    size_t   repeatCount = argc > 1 ? strtoul(argv[1], nullptr, 10) : 10;
+    uint32_t seed        = argc > 2 ? (uint32_t)strtoul(argv[2], nullptr, 10) : 1;
+
+    Parser parser(Parser::DefaultTraits(), Parser::KEEP_TREE);
+    parser.DeclareVariable("x");
+    parser.DeclareVariable("y");
+    parser.DeclareVariable("z");
+
+    CorpusGenerator generator(seed);
+    const Corpus corpora[] = {
+        generator.Short(1000),
+        generator.Deep(100),
+        generator.Nested(10),
+        generator.LongAvg(100),
+        generator.FunctionHeavy(1000),
+        generator.ConstantHeavy(1000),
+        generator.Aggregates(100)
+    };
+
+    printf("corpus\tstage\texpressions\tns_per_expression\tallocations_per_expression\texpressions_per_second\n");
+    for (const Corpus& corpus : corpora) {
+        RunCorpus(parser, corpus, repeatCount);
+    }
+
+    // Accuracy and speed of real types
+    printf("\ncorpus\ttype\tmax_relative_error\tmean_relative_error\tns_per_evaluation\tns_per_batch_row\n");
+    for (const Corpus& corpus : corpora) {
+        RunPrecision<Parser::FloatTraits>("float", corpus, repeatCount);
+        RunPrecision<Parser::DefaultTraits>("double", corpus, repeatCount);
+        RunPrecision<Parser::LongDoubleTraits>("long double", corpus, repeatCount);
+    }
+    return 0;
+}
@@ -0,0 +1,90 @@
+#ifndef PARSER_CORE_ARENA_HEADER
+#define PARSER_CORE_ARENA_HEADER
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <new>
+#include <utility>
+
+#include <string_view>
+
+namespace core {
+    // Monotonic allocator: memory is released only all at once (Reset or destruction),
+    // destructors of created objects aren't called
+    class Arena {
+    public:
+        static constexpr size_t DEFAULT_BLOCK_SIZE = 4096;
+
+    public:
+        Arena(size_t blockSize = DEFAULT_BLOCK_SIZE) noexcept;
+
+        // Use caller-supplied buffer as the first block (buffer isn't owned by arena)
+        Arena(void* buffer, size_t size, size_t blockSize = DEFAULT_BLOCK_SIZE) noexcept;
+
+        Arena(const Arena&) = delete;
+        Arena(Arena&& other) noexcept;
+
+        ~Arena();
+
+        Arena& operator=(const Arena&) = delete;
+        Arena& operator=(Arena&& other) noexcept;
+
+    public:
+        void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+        template <typename T, typename... Args>
+        T* Create(Args&&... args) {
+            return ::new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        }
+
+        template <typename T>
+        T* CreateArray(size_t count) {
+            T* array = static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+            for (size_t i = 0; i < count; ++i) {
+                ::new (array + i) T();
+            }
+            return array;
+        }
+
+        std::string_view CopyString(const char* s, size_t length);
+
+        // Rewind to the first block, allocated blocks are kept for reuse
+        void Reset() noexcept;
+
+    public:
+        // Heap allocations made by this arena
+        size_t GetAllocationCount() const noexcept { return m_allocationCount; }
+
+        // Bytes handed out since the last Reset
+        size_t GetUsedBytes() const noexcept { return m_usedBytes; }
+
+        // Heap allocations made by all arenas of the process
+        static uint64_t GetTotalAllocationCount() noexcept;
+
+    private:
+        struct _Block {
+        public:
+            _Block* next;
+            size_t  size;
+            bool    isOwned;
+        };
+
+    private:
+        _Block* _CreateBlock(size_t minSize);
+        void    _Free() noexcept;
+
+    private:
+        _Block* m_head    = nullptr;
+        _Block* m_current = nullptr;
+        size_t  m_offset  = 0;
+
+        size_t m_blockSize       = DEFAULT_BLOCK_SIZE;
+        size_t m_allocationCount = 0;
+        size_t m_usedBytes       = 0;
+
+        static std::atomic<uint64_t> s_TotalAllocationCount;
+    };
+}
+
+#endif // !PARSER_CORE_ARENA_HEADER
@@ -0,0 +1,198 @@
+#ifndef PARSER_CORE_DUAL_HEADER
+#define PARSER_CORE_DUAL_HEADER
+
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <array>
+#include <limits>
+#include <string_view>
+
+#include <parser/parser.h>
+
+namespace core {
+    // Value with its partial derivatives by N variables (forward-mode automatic differentiation)
+    template <size_t N>
+    struct Dual {
+    public:
+        Dual(double value = 0.0) : value(value) {}
+
+        // Variable with the derivative 1 by itself
+        static Dual Variable(double value, size_t index) {
+            Dual result(value);
+            result.derivatives[index] = 1.0;
+            return result;
+        }
+
+    public:
+        double                value = 0.0;
+        std::array<double, N> derivatives = {};
+    };
+
+    template <size_t N>
+    Dual<N> operator-(const Dual<N>& a) {
+        Dual<N> result(-a.value);
+        for (size_t i = 0; i < N; ++i) {
+            result.derivatives[i] = -a.derivatives[i];
+        }
+        return result;
+    }
+
+    template <size_t N>
+    Dual<N> operator+(const Dual<N>& a, const Dual<N>& b) {
+        Dual<N> result(a.value + b.value);
+        for (size_t i = 0; i < N; ++i) {
+            result.derivatives[i] = a.derivatives[i] + b.derivatives[i];
+        }
+        return result;
+    }
+
+    template <size_t N>
+    Dual<N> operator-(const Dual<N>& a, const Dual<N>& b) {
+        Dual<N> result(a.value - b.value);
+        for (size_t i = 0; i < N; ++i) {
+            result.derivatives[i] = a.derivatives[i] - b.derivatives[i];
+        }
+        return result;
+    }
+
+    template <size_t N>
+    Dual<N> operator*(const Dual<N>& a, const Dual<N>& b) {
+        Dual<N> result(a.value * b.value);
+        for (size_t i = 0; i < N; ++i) {
+            result.derivatives[i] = a.derivatives[i] * b.value + a.value * b.derivatives[i];
+        }
+        return result;
+    }
+
+    template <size_t N>
+    Dual<N> operator/(const Dual<N>& a, const Dual<N>& b) {
+        Dual<N> result(a.value / b.value);
+        for (size_t i = 0; i < N; ++i) {
+            result.derivatives[i] = (a.derivatives[i] - result.value * b.derivatives[i]) / b.value;
+        }
+        return result;
+    }
+
+    // Equal values and derivatives (used to match constants)
+    template <size_t N>
+    bool operator==(const Dual<N>& a, const Dual<N>& b) {
+        return a.value == b.value && a.derivatives == b.derivatives;
+    }
+
+    template <size_t N>
+    bool operator!=(const Dual<N>& a, const Dual<N>& b) { return !(a == b); }
+
+    // Order of values only
+    template <size_t N>
+    bool operator<(const Dual<N>& a, const Dual<N>& b) { return a.value < b.value; }
+
+    template <size_t N>
+    bool operator>(const Dual<N>& a, const Dual<N>& b) { return b < a; }
+
+    // Traits of Parser, which evaluates expressions with derivatives by N variables:
+    //     Parser<DualTraits<2>> parser; (variables are passed as Dual<2>::Variable(value, slot))
+    template <size_t N>
+    struct DualTraits {
+    public:
+        using Integer = int64_t;
+        using Real    = Dual<N>;
+
+    public:
+        DualTraits() :
+        sqrtFunction(Sqrt),
+        powFunction(Pow),
+        sinFunction(Sin),
+        cosFunction(Cos),
+        tanFunction(Tan),
+        cotFunction(Cot),
+        lnFunction(Ln)
+        {}
+
+    public:
+        static bool StringToInteger(std::string_view s, Integer& result) noexcept {
+            return ParserBase::DefaultTraits::StringToInteger(s, result);
+        }
+
+        static bool StringToReal(std::string_view s, Real& result) noexcept {
+            double value = 0.0;
+            if (!ParserBase::DefaultTraits::StringToReal(s, value)) {
+                return false;
+            }
+            result = Real(value);
+            return true;
+        }
+
+    public:
+        static Real Sqrt(Real a) { return _Chain(a, std::sqrt(a.value), 0.5 / std::sqrt(a.value)); }
+        static Real Sin(Real a)  { return _Chain(a, std::sin(a.value), std::cos(a.value)); }
+        static Real Cos(Real a)  { return _Chain(a, std::cos(a.value), -std::sin(a.value)); }
+        static Real Ln(Real a)   { return _Chain(a, std::log(a.value), 1.0 / a.value); }
+
+        static Real Tan(Real a) {
+            double value = std::tan(a.value);
+            return _Chain(a, value, 1.0 + value * value);
+        }
+
+        static Real Cot(Real a) {
+            double value = 1.0 / std::tan(a.value);
+            return _Chain(a, value, -(1.0 + value * value));
+        }
+
+        // Derivative by exponent is taken only where exponent isn't constant (ln of negative base is NaN)
+        static Real Pow(Real a, Real b) {
+            Real result(std::pow(a.value, b.value));
+
+            double byBase     = b.value == 0.0 ? 0.0 : b.value * std::pow(a.value, b.value - 1.0);
+            double byExponent = a.value == 0.0 ? 0.0 : result.value * std::log(a.value);
+
+            for (size_t i = 0; i < N; ++i) {
+                result.derivatives[i] = byBase * a.derivatives[i];
+                if (b.derivatives[i] != 0.0) {
+                    result.derivatives[i] += byExponent * b.derivatives[i];
+                }
+            }
+            return result;
+        }
+
+    public:
+        Real(*sqrtFunction)(Real);
+        Real(*powFunction)(Real, Real);
+
+        Real(*sinFunction)(Real);
+        Real(*cosFunction)(Real);
+        Real(*tanFunction)(Real);
+        Real(*cotFunction)(Real);
+
+        Real(*lnFunction)(Real);
+
+    private:
+        // f(a) with derivative f'(a)
+        static Real _Chain(const Real& a, double value, double derivative) {
+            Real result(value);
+            for (size_t i = 0; i < N; ++i) {
+                result.derivatives[i] = derivative * a.derivatives[i];
+            }
+            return result;
+        }
+    };
+}
+
+namespace std {
+    // Limits of the value with zero derivatives (infinity is the identity of min and max reductions)
+    template <size_t N>
+    struct numeric_limits<core::Dual<N>> : numeric_limits<double> {
+    public:
+        static core::Dual<N> min()           noexcept { return numeric_limits<double>::min(); }
+        static core::Dual<N> max()           noexcept { return numeric_limits<double>::max(); }
+        static core::Dual<N> lowest()        noexcept { return numeric_limits<double>::lowest(); }
+        static core::Dual<N> epsilon()       noexcept { return numeric_limits<double>::epsilon(); }
+        static core::Dual<N> round_error()   noexcept { return numeric_limits<double>::round_error(); }
+        static core::Dual<N> infinity()      noexcept { return numeric_limits<double>::infinity(); }
+        static core::Dual<N> quiet_NaN()     noexcept { return numeric_limits<double>::quiet_NaN(); }
+        static core::Dual<N> signaling_NaN() noexcept { return numeric_limits<double>::signaling_NaN(); }
+        static core::Dual<N> denorm_min()    noexcept { return numeric_limits<double>::denorm_min(); }
+    };
+}
+
+#endif // !PARSER_CORE_DUAL_HEADER
@@ -0,0 +1,106 @@
+#ifndef PARSER_CORE_EXPRESSION_FILE_HEADER
+#define PARSER_CORE_EXPRESSION_FILE_HEADER
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+#include <string_view>
+
+#include <parser/parser.h>
+
+namespace core {
+    // Compiled expressions stored in one file, which is mapped to memory and evaluated in place.
+    // Sections are referenced by offsets from the begin of the file, so it doesn't depend on the load address
+    class ExpressionFile {
+    public:
+        static constexpr uint32_t VERSION = 1;
+
+        enum class Error {
+            NONE,
+
+            CANT_OPEN,
+            CANT_WRITE,
+            INVALID_HEADER,      // isn't expression file or is truncated
+            UNSUPPORTED_VERSION, // other format version, byte order or number size
+            CHECKSUM_MISMATCH,
+            INVALID_PROGRAM      // code reads outside of its constants, variables or stack
+        };
+
+        // Stored expression (points to the mapped file)
+        struct Expression {
+        public:
+            // Evaluate with the traits of "parser", "variables" must contain at least variableCount values
+            template <typename Parser>
+            double Evaluate(const Parser& parser, const double* variables = nullptr) const {
+                static_assert(std::is_same_v<typename Parser::Real, double>, "expression file stores double constants");
+                return parser.EvaluateProgram(code, codeSize, constants, stackSize, variables);
+            }
+
+        public:
+            const ParserBase::Instruction* code      = nullptr;
+            const double*                  constants = nullptr;
+
+            uint32_t codeSize      = 0;
+            uint32_t constantCount = 0;
+            uint32_t stackSize     = 0;
+            uint32_t variableCount = 0;
+
+            std::string_view source; // expression text
+        };
+
+    public:
+        ExpressionFile() = default;
+        ExpressionFile(ExpressionFile&& other) noexcept;
+        ExpressionFile(const ExpressionFile&) = delete;
+
+        ~ExpressionFile();
+
+        ExpressionFile& operator=(ExpressionFile&& other) noexcept;
+        ExpressionFile& operator=(const ExpressionFile&) = delete;
+
+    public:
+        // Map the file, check its header, checksum and every program (nothing is done per expression after that)
+        Error Open(const char* path);
+        void Close() noexcept;
+
+        size_t GetExpressionCount() const noexcept { return m_expressionCount; }
+        Expression GetExpression(size_t index) const noexcept;
+
+        // Names of variable slots used by the expressions
+        size_t GetVariableCount() const noexcept { return m_variableCount; }
+        std::string_view GetVariableName(size_t slot) const noexcept;
+
+        // "variableNames" are names of the slots 0...variableCount - 1
+        static Error Write(
+            const char* path,
+            const Expression* expressions,
+            size_t count,
+            const std::string_view* variableNames,
+            size_t variableCount
+        );
+
+    private:
+        struct _Header;
+        struct _ExpressionRecord;
+        struct _NameRecord;
+
+    private:
+        Error _Validate() noexcept;
+
+        static uint64_t _Checksum(const uint8_t* data, size_t size) noexcept;
+
+    private:
+        const uint8_t* m_data = nullptr;
+        size_t         m_size = 0;
+
+        bool                       m_isMapped = false;
+        std::unique_ptr<uint8_t[]> m_buffer; // file contents, if it can't be mapped
+
+        size_t m_expressionCount = 0;
+        size_t m_variableCount   = 0;
+    };
+}
+
+#endif // !PARSER_CORE_EXPRESSION_FILE_HEADER
@@ -2,27 +2,45 @@
 #define PARSER_CORE_PARSER_HEADER
 
 #include <cstdint>
+#include <cstring>
+#include <algorithm>
 #include <memory>
 #include <functional>
+#include <type_traits>
+#include <limits>
+#include <array>
 
 #include <string>
+#include <string_view>
 #include <vector>
+#include <list>
 #include <map>
+#include <queue>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+
+#include <parser/arena.h>
+#include <parser/vector_kernels.h>
+#include <parser/thread_pool.h>
 
 namespace core {
     class ParserBase {
     public:
-        struct DefaultTraits {
+        // Builtins of the standard library in precision of RealT (defined for float, double and long double)
+        template <typename RealT>
+        struct BasicTraits {
         public:
             using Integer = int64_t;
-            using Real    = double;
+            using Real    = RealT;
 
         public:
-            DefaultTraits();
+            BasicTraits();
 
         public:
-            static Integer StringToInteger(const std::string& s);
-            static Real    StringToReal(const std::string& s);
+            // Locale-independent, return false if "s" isn't representable number
+            static bool StringToInteger(std::string_view s, Integer& result) noexcept;
+            static bool StringToReal(std::string_view s, Real& result) noexcept;
 
         public:
             Real(*sqrtFunction)(Real);
@@ -36,6 +54,10 @@ namespace core {
             Real(*lnFunction)(Real);
         };
 
+        using DefaultTraits    = BasicTraits<double>;
+        using FloatTraits      = BasicTraits<float>;       // twice as many SIMD lanes in batch evaluation
+        using LongDoubleTraits = BasicTraits<long double>; // extended precision, where the platform has it
+
         enum class ExpressionError {
             IS_VALID,
             
@@ -43,7 +65,30 @@ namespace core {
             INVALID_OPERATOR_PLACE,
             INVALID_PARENTHESES,
             INVALID_ARGUMENT_COUNT,
-            INVALID_COMMA_PLACE
+            INVALID_COMMA_PLACE,
+            INVALID_TOKEN,
+            UNBOUND_VARIABLE,
+            TOO_DEEP,
+            FUNCTION_WITHOUT_PARENTHESES,
+
+            COUNT
+        };
+
+        // Error with the source span of the token, which caused it
+        struct ErrorInfo {
+        public:
+            constexpr ErrorInfo() = default;
+            constexpr ErrorInfo(ExpressionError code, uint32_t offset = 0, uint32_t length = 0) :
+                code(code), offset(offset), length(length) {}
+
+            // Compares with ExpressionError as the code only
+            constexpr operator ExpressionError() const noexcept { return code; }
+
+        public:
+            ExpressionError code = ExpressionError::IS_VALID;
+
+            uint32_t offset = 0; // in bytes from the begin of the expression
+            uint32_t length = 0; // zero at the end of expression
         };
 
         template <typename T, typename ErrorT>
@@ -65,6 +110,40 @@ namespace core {
                 ::new (&m_error) ErrorT(error);
             }
 
+            Result(const Result& other) : m_hasValue(other.m_hasValue) {
+                if (m_hasValue) {
+                    ::new (&m_value) T(other.m_value);
+                }
+                else {
+                    ::new (&m_error) ErrorT(other.m_error);
+                }
+            }
+
+            Result(Result&& other) : m_hasValue(other.m_hasValue) {
+                if (m_hasValue) {
+                    ::new (&m_value) T(std::move(other.m_value));
+                }
+                else {
+                    ::new (&m_error) ErrorT(std::move(other.m_error));
+                }
+            }
+
+            Result& operator=(const Result& other) {
+                if (this != &other) {
+                    this->~Result();
+                    ::new (this) Result(other);
+                }
+                return *this;
+            }
+
+            Result& operator=(Result&& other) {
+                if (this != &other) {
+                    this->~Result();
+                    ::new (this) Result(std::move(other));
+                }
+                return *this;
+            }
+
             ~Result() {
                 if (m_hasValue) {
                     m_value.~T();
@@ -107,7 +186,9 @@ namespace core {
 
                 RIGHT_TO_LEFT = 0x400,
 
-                ANY_ARG_COUNT = 0x800
+                ANY_ARG_COUNT = 0x800,
+
+                VARIABLE = 0x1000
             };
 
             enum ID : uint64_t {
@@ -134,15 +215,21 @@ namespace core {
 
                 LN,
 
-                AVG
+                // any arg count
+                AVG,
+                SUM,
+                MIN,
+                MAX,
+                STDDEV
             };
 
+            // Type, ID and both binding powers take the low 32 bits (packed word of TokenStream)
             enum : uint64_t {
-                ID_BITS     = 8,
-                ID_BITSHIFT = 12,
+                ID_BITS     = 5,
+                ID_BITSHIFT = 13,
                 ID_BITMASK  = (1ull << ID_BITS) - 1,
                 
-                BINDING_POWER_BITS = 8,
+                BINDING_POWER_BITS = 7,
                 BINDING_POWER_BITMASK  = (1ull << BINDING_POWER_BITS) - 1,
                 BINDING_POWER_BITSHIFT = ID_BITSHIFT + ID_BITS,
 
@@ -153,640 +240,3160 @@ namespace core {
             };
 
         public:
-            // Alternative of "void"
-            class Data {
-            public:
-                virtual ~Data() = default;
-            };
+            constexpr Token() = default;
+            constexpr Token(uint64_t info) : info(info) {}
+            constexpr Token(uint64_t info, uint32_t offset, uint32_t length) :
+                info(info), offset(offset), length(length) {}
 
-            template <typename T>
-            class SpecifiedData : public Data {
-            public:
-                SpecifiedData() = default;
-                SpecifiedData(const T& value) : value(value) {}
-                SpecifiedData(T&& value) : value(std::move(value)) {}
+        public:
+            constexpr bool HasType(uint64_t type) const noexcept { return (info & type) == type; }
+            constexpr bool Is(ID id) const noexcept { return ((info >> ID_BITSHIFT) & ID_BITMASK) == id; }
 
-                virtual ~SpecifiedData() = default;
+            // Get Binding Power
+            constexpr uint8_t GetBP() const noexcept { return (info >> BINDING_POWER_BITSHIFT) & BINDING_POWER_BITMASK; }
 
-            public:
-                T value;
-            };
+            // Binding Power for alternative version of the same token
+            constexpr uint8_t GetBP2() const noexcept {
+                return (info >> (BINDING_POWER_BITSHIFT + BINDING_POWER_BITS)) & BINDING_POWER_BITMASK;
+            }
+
+            constexpr ID GetID() const noexcept { return (ID)((info >> ID_BITSHIFT) & ID_BITMASK); }
+            constexpr size_t GetFunctionArgCount() const noexcept { return (info >> FUNCTION_ARGS_BITSHIFT) & FUNCTION_ARGS_BITMASK; }
 
         public:
-            Token() = default;
-            Token(Token&& other) : info(other.info), data(std::move(other.data)) {
-                other.info = 0;
+            constexpr void SetBP(uint8_t bp) noexcept {
+                info &= ~(BINDING_POWER_BITMASK << BINDING_POWER_BITSHIFT);
+                info |= (uint64_t)bp << BINDING_POWER_BITSHIFT;
             }
 
-            Token(uint64_t info) : info(info) {}
-            Token(uint64_t info, std::unique_ptr<Data>&& data) :
-                info(info), data(std::move(data)) {}
+            constexpr void SetFunctionArgCount(size_t count) noexcept {
+                info &= ~(FUNCTION_ARGS_BITMASK << FUNCTION_ARGS_BITSHIFT);
+                info |= count << FUNCTION_ARGS_BITSHIFT;
+            }
 
         public:
-            bool HasType(uint64_t type) const noexcept;
-            bool Is(ID id) const noexcept;
+            // First 13 bits for type
+            // Next 5 bits for ID
+            // Next 14 bits for BP1 and BP2
+            // High 32 bits for function arg count
+            uint64_t info = 0;
+
+            // Source span of the token in the expression (implicit tokens have zero length)
+            uint32_t offset = 0;
+            uint32_t length = 0;
+        };
 
-            // Get Binding Power
-            uint8_t GetBP() const noexcept;
+        static_assert((uint64_t)Token::STDDEV <= Token::ID_BITMASK, "token ID doesn't fit its bits");
+        static_assert(Token::FUNCTION_ARGS_BITSHIFT == 32, "packed token word must hold all bits but arg count");
 
-            // Binding Power for alternative version of the same token
-            uint8_t GetBP2() const noexcept;
+    public:
+        // Element of the compiled expression (postfix stack machine program)
+        struct Instruction {
+        public:
+            enum OpCode : uint8_t {
+                PUSH_CONSTANT, // operand is index in constant pool
+                PUSH_VARIABLE, // operand is variable slot
+
+                NEGATE,
+                ADD,
+                SUBTRACT,
+                MULTIPLY,
+                DIVIDE,
+                POWER,
+
+                // Same order as function IDs of Token
+                SQRT,
+                POW,
+                SIN,
+                COS,
+                TAN,
+                COT,
+                LN,
+
+                // Aggregates, operand is argument count
+                AVG,
+                SUM,
+                MIN,
+                MAX,
+                STDDEV // population standard deviation
+            };
 
-            ID GetID() const noexcept;
-            size_t GetFunctionArgCount() const noexcept;
+        public:
+            // Count of stack values consumed by the instruction
+            constexpr size_t GetArgCount() const noexcept {
+                switch (opcode) {
+                    case PUSH_CONSTANT:
+                    case PUSH_VARIABLE: return 0;
+
+                    case ADD:
+                    case SUBTRACT:
+                    case MULTIPLY:
+                    case DIVIDE:
+                    case POWER:
+                    case POW: return 2;
+
+                    case AVG:
+                    case SUM:
+                    case MIN:
+                    case MAX:
+                    case STDDEV: return operand;
+
+                    default: return 1;
+                }
+            }
 
         public:
-            void SetBP(uint8_t bp) noexcept;
-            void SetFunctionArgCount(size_t count) noexcept;
+            OpCode   opcode  = PUSH_CONSTANT;
+            uint32_t operand = 0;
+        };
 
+        struct CacheStatistics {
         public:
-            // First 11 bits for type
-            // Next 8 bits for ID
-            // Next 16 bits for BP1 and BP2
-            // 
-            uint64_t              info = 0;
+            uint64_t hits      = 0;
+            uint64_t misses    = 0;
+            uint64_t evictions = 0;
 
-            std::unique_ptr<Data> data;
+            size_t entryCount = 0;
+            size_t byteCount  = 0;
         };
 
-    public:
-        static uint64_t CreateFunctionTokenInfo(Token::ID id, size_t argCount) noexcept;
-        static uint64_t CreateOperatorTokenInfo(Token::ID id, uint8_t bp = 0, uint8_t bp2 = 0) noexcept;
+        // Collected only if built with PARSER_INSTRUMENTATION, zeros otherwise
+        struct Statistics {
+        public:
+            enum Stage : size_t {
+                SCAN, // fused Tokenize, Specify and Validate
+                BUILD,
+                EVALUATE,
 
-    protected:
-        static std::map<std::string, uint64_t> s_FunctionMap;
-        static std::map<char, uint64_t>        s_OperatorMap;
-        static std::map<char, uint64_t>        s_SupportedSymbolMap;
-    };
+                STAGE_COUNT
+            };
 
-    template <typename Traits = ParserBase::DefaultTraits>
-    class Parser : public ParserBase {
-    public:
-        using Integer = typename Traits::Integer;
-        using Real    = typename Traits::Real;
+        public:
+            // CPU cycles (nanoseconds if there is no cycle counter) spent in each stage
+            uint64_t stageCycles[STAGE_COUNT] = {};
 
-    public:
-        Parser() = default;
+            uint64_t compileCount    = 0; // compilations, which passed validation
+            uint64_t evaluationCount = 0;
+
+            uint64_t tokenCount = 0;
+            uint64_t nodeCount  = 0; // instructions of the compiled programs
+            uint64_t maxDepth   = 0; // of parentheses
+
+            // Blocks allocated by parse arenas and buffers of tokens and compiled programs
+            uint64_t heapAllocationCount = 0;
+
+            // Failed compilations and evaluations by ExpressionError
+            uint64_t errorCounts[(size_t)ExpressionError::COUNT] = {};
+        };
+
+        enum Flag : uint64_t {
+            // Keep expression tree next to the compiled program (for debugging)
+            KEEP_TREE = 0x1,
+
+            // Don't fold constants and simplify the compiled program
+            DISABLE_OPTIMIZATION = 0x2,
+
+            // Allow simplifications, which can change sign of zero result (x + 0 = x)
+            IGNORE_SIGNED_ZEROS = 0x4,
+
+            // Compile programs to native code (x86-64 only, "double" reals), the interpreter is used otherwise
+            ENABLE_JIT = 0x8
+        };
+
+        // Default of SetDepthLimit, parsing and evaluation don't use call stack for nesting
+        static constexpr size_t DEFAULT_DEPTH_LIMIT = 1 << 16;
 
     public:
-        std::vector<Token> Tokenize(const char* expression) const {
-            size_t i = 0;
+        static constexpr uint64_t CreateFunctionTokenInfo(Token::ID id, size_t argCount) noexcept {
+            return Token::FUNCTION | Token::SYMBOL | (id << Token::ID_BITSHIFT) |
+                ((30) << Token::BINDING_POWER_BITSHIFT) | (argCount << Token::FUNCTION_ARGS_BITSHIFT);
+        }
 
-            std::vector<Token> result;
+        static constexpr uint64_t CreateOperatorTokenInfo(Token::ID id, uint8_t bp = 0, uint8_t bp2 = 0) noexcept {
+            return Token::OPERATOR | Token::SYMBOL | (id << Token::ID_BITSHIFT) |
+                ((((uint64_t)bp2 << Token::BINDING_POWER_BITS) | bp) << Token::BINDING_POWER_BITSHIFT);
+        }
 
-            while (expression[i] != '\0') {
-                if (isspace(expression[i])) {
-                    ++i;
-                    continue;
-                }
+    protected:
+        enum CharacterClass : uint8_t {
+            INVALID_CHARACTER,
+            END_CHARACTER,    // '\0'
+            SPACE_CHARACTER,
+            DIGIT_CHARACTER,
+            LETTER_CHARACTER,
+            TOKEN_CHARACTER   // operator or symbol, "tokenInfo" is its token
+        };
 
-                if (isdigit(expression[i])) { // number
-                    Token numToken = _ParseNumber(expression, i);
-                    if (numToken.info == 0) {
-                        result.clear();
-                        return result;
-                    }
-                    result.emplace_back(std::move(numToken));
-                    continue;
+        struct CharacterInfo {
+        public:
+            CharacterClass characterClass = INVALID_CHARACTER;
+            uint64_t       tokenInfo      = 0;
+        };
+
+        struct BuiltinInfo {
+        public:
+            std::string_view name;
+            uint64_t         tokenInfo = 0;
+        };
+
+        // Names declared at runtime (constants and variables), open addressing with linear probing
+        class _IdentifierTable {
+        public:
+            struct Entry {
+            public:
+                std::string name;
+                uint64_t    hash  = 0;
+                uint64_t    info  = 0; // token info, 0 for empty entry
+                size_t      index = 0; // constant index or variable slot
+            };
+
+        public:
+            const Entry* Find(std::string_view name) const noexcept {
+                if (m_entries.empty()) {
+                    return nullptr;
                 }
 
-                if (isalpha(expression[i])) { // constant, function
-                    Token idToken = _ParseID(expression, i);
-                    if (idToken.info == 0) {
-                        result.clear();
-                        return result;
+                uint64_t hash = _Hash(name);
+                size_t   mask = m_entries.size() - 1;
+                for (size_t i = hash & mask; m_entries[i].info != 0; i = (i + 1) & mask) {
+                    if (m_entries[i].hash == hash && m_entries[i].name == name) {
+                        return &m_entries[i];
                     }
-                    result.emplace_back(std::move(idToken));
-                    continue;
                 }
+                return nullptr;
+            }
 
-                auto opIt = s_OperatorMap.find(expression[i]);
-                if (opIt != s_OperatorMap.cend()) { // operator
-                    result.emplace_back(opIt->second);
-                    ++i;
-                    continue;
-                }
+            // Existing entry or new one with zero info, which must be filled by the caller
+            Entry& Insert(std::string_view name);
 
-                auto symbolIt = s_SupportedSymbolMap.find(expression[i]);
-                if (symbolIt != s_SupportedSymbolMap.cend()) {
-                    result.emplace_back(symbolIt->second);
-                    ++i;
-                    continue;
+        private:
+            // FNV-1a
+            static uint64_t _Hash(std::string_view name) noexcept {
+                uint64_t hash = 14695981039346656037ull;
+                for (char c : name) {
+                    hash = (hash ^ (unsigned char)c) * 1099511628211ull;
                 }
-
-                result.clear();
-                break;
+                return hash;
             }
-            
-            result.emplace_back(Token::EOEX | Token::EOEX_LIKE);
-            return result;
-        };
 
-        // Specify operators (some operators depend on context) and function arg count, add implicit tokens, 
-        // Return list of implicit tokens
-        std::vector<std::pair<size_t, Token>> Specify(std::vector<Token>& tokens) const {
-            Token    emptyToken(0);
-            Token*   prevToken          = &emptyToken;
-            uint64_t multiplicationInfo = s_OperatorMap['*'];
-            
-            // open paren depth
-            size_t depth = 0;
+        private:
+            std::vector<Entry> m_entries; // size is power of 2
+            size_t             m_size = 0;
+        };
 
-            size_t commas = 0;
+        // Call of variadic function, which isn't closed yet
+        struct _VariadicCall {
+        public:
+            size_t tokenIndex = 0;
+            size_t depth      = 0; // of its parentheses
+            size_t commas     = 0;
+        };
 
-            Token* anyArgCountToken      = nullptr;
-            size_t anyArgCountTokenDepth = 0;
+        // Resolves unary/binary operators and arg counts of variadic functions, token by token.
+        // "CallStack" is container of _VariadicCall (fixed-size one makes the specifier usable in constant expressions)
+        template <typename CallStack>
+        class _BasicSpecifier {
+        public:
+            // Operand is followed by parenthesis, function or number of the other kind
+            constexpr bool IsImplicitMultiplication(const Token& token) const noexcept {
+                if (!(m_prevToken.HasType(Token::NUMBER) || m_prevToken.Is(Token::CLOSE_PAREN))) {
+                    return false;
+                }
+                if (token.Is(Token::OPEN_PAREN) || token.HasType(Token::FUNCTION)) {
+                    return true;
+                }
+                if (token.HasType(Token::NUMBER)) {
+                    // Non-constant before constant or non-number before number
+                    return (token.HasType(Token::CONSTANT) && !m_prevToken.HasType(Token::CONSTANT)) ||
+                        (!token.HasType(Token::CONSTANT) && (m_prevToken.HasType(Token::CONSTANT) ||
+                        !m_prevToken.HasType(Token::NUMBER)));
+                }
+                return false;
+            }
 
-            std::vector<std::pair<size_t, Token>> implicitTokens;
-            
-            size_t tokenCount = tokens.size();
-            for (size_t i = 0; i < tokenCount; ++i) {
-                Token& token = tokens[i];
+            // Specify the last token of "tokens", arg count is set to the variadic function on its close paren
+            template <typename Tokens>
+            constexpr void Specify(Tokens& tokens) {
+                Specify(tokens.back(), tokens.size() - 1, [&tokens](size_t index, size_t argCount) {
+                    tokens[index].SetFunctionArgCount(argCount);
+                });
+            }
 
-                bool isLeftOperand = prevToken->HasType(Token::NUMBER) || prevToken->Is(Token::CLOSE_PAREN);
+            // Specify "token", "index" of variadic function is passed to "setArgCount" on its close paren
+            template <typename SetArgCount>
+            constexpr void Specify(Token& token, size_t index, SetArgCount&& setArgCount) {
+                bool isLeftOperand = m_prevToken.HasType(Token::NUMBER) || m_prevToken.Is(Token::CLOSE_PAREN);
 
                 if (token.Is(Token::COMMA)) {
-                    ++commas;
+                    if (!m_calls.empty() && m_calls.back().depth == m_depth) {
+                        ++m_calls.back().commas;
+                    }
                 }
                 else if (token.Is(Token::CLOSE_PAREN)) {
-                    if (anyArgCountToken && anyArgCountTokenDepth == depth) {
-                        anyArgCountToken->SetFunctionArgCount(prevToken->Is(Token::OPEN_PAREN) ? 0 : commas + 1);
-                        commas = 0;
-                        anyArgCountToken = nullptr;
+                    if (!m_calls.empty() && m_calls.back().depth == m_depth) {
+                        const _VariadicCall& call = m_calls.back();
+                        setArgCount(call.tokenIndex, m_prevToken.Is(Token::OPEN_PAREN) ? 0 : call.commas + 1);
+                        m_calls.pop_back();
                     }
-                    depth -= depth > 0;
+                    m_depth -= m_depth > 0;
                 }
-                // Binary/Unary operator
+                // Binary, if has left operand, otherwise unary
                 else if (token.HasType(Token::BINARY | Token::UNARY)) {
-                    // Binary, if has left operand, otherwise unary
                     token.info &= ~(isLeftOperand ? Token::UNARY : Token::BINARY);
                     if (!isLeftOperand) {
                         token.SetBP(token.GetBP2());
                     }
                 }
                 else if (token.Is(Token::OPEN_PAREN)) {
-                    ++depth;
-                    // Implicit multiplication first case (operand before '(')
-                    if (isLeftOperand) {
-                        implicitTokens.emplace_back(i, Token(multiplicationInfo));
-                    }
-                }
-                // Implicit multiplication second case (number before constant, and vice versa)
-                else if (token.HasType(Token::NUMBER) && isLeftOperand) {
-                    bool condition = (token.HasType(Token::CONSTANT) && !prevToken->HasType(Token::CONSTANT)) ||
-                        (!token.HasType(Token::CONSTANT) && (prevToken->HasType(Token::CONSTANT) ||
-                        !prevToken->HasType(Token::NUMBER)));
-
-                    // Non-constant before constant or non-number before number
-                    if (condition) {
-                        implicitTokens.emplace_back(i, Token(multiplicationInfo));
-                    }
+                    ++m_depth;
                 }
-                else if (token.HasType(Token::FUNCTION)) {
-                    // Implicit multiplication third case (operand before function)
-                    if (isLeftOperand) {
-                        implicitTokens.emplace_back(i, Token(multiplicationInfo));
-                    }
-
-                    if (token.HasType(Token::ANY_ARG_COUNT)) {
-                        anyArgCountToken      = &token;
-                        anyArgCountTokenDepth = depth + 1;
-                    }
+                else if (token.HasType(Token::FUNCTION | Token::ANY_ARG_COUNT)) {
+                    _VariadicCall call;
+                    call.tokenIndex = index;
+                    call.depth      = m_depth + 1;
+                    m_calls.push_back(call);
                 }
 
-                prevToken = &token;
+                m_prevToken = token;
             }
-            return implicitTokens;
-        }
 
-        // Check, if expression tokens are compatible
-        ExpressionError Validate(const std::vector<Token>& tokens) const {
-            Token emptyToken(0);
-            const Token* prevToken = &emptyToken;
+        private:
+            Token  m_prevToken = Token(0);
+            size_t m_depth     = 0; // open paren depth
 
-            size_t openParen = 0;
-            
-            size_t tokenCount = tokens.size();
-            for (size_t i = 0; i < tokenCount; ++i) {
-                const Token& token = tokens[i];
+            CallStack m_calls;
+        };
+
+        using _Specifier = _BasicSpecifier<std::vector<_VariadicCall>>;
+
+        // Checks, if neighbour tokens are compatible, token by token
+        class _Validator {
+        public:
+            constexpr ExpressionError Validate(const Token& token) noexcept {
+                // Arguments are always in parentheses (sqrt 4 isn't a call)
+                if (m_prevToken.HasType(Token::FUNCTION) && !token.Is(Token::OPEN_PAREN)) {
+                    return ExpressionError::FUNCTION_WITHOUT_PARENTHESES;
+                }
 
                 if (token.Is(Token::OPEN_PAREN)) {
-                    ++openParen;
+                    if (m_openParen++ == 0) {
+                        m_outerParen = token;
+                    }
                 }
                 else if (token.Is(Token::CLOSE_PAREN)) {
-                    if (openParen == 0) {
+                    if (m_openParen == 0) {
                         return ExpressionError::INVALID_PARENTHESES;
                     }
-                    if (prevToken->Is(Token::COMMA)) {
+                    if (m_prevToken.Is(Token::COMMA)) {
                         return ExpressionError::INVALID_COMMA_PLACE;
                     }
-                    --openParen;
+                    --m_openParen;
                 }
 
                 // Number before number, or constant before constant
-                if ((token.HasType(Token::CONSTANT) && prevToken->HasType(Token::CONSTANT)) ||
+                if ((token.HasType(Token::CONSTANT) && m_prevToken.HasType(Token::CONSTANT)) ||
                     (token.HasType(Token::NUMBER) && !token.HasType(Token::CONSTANT) &&
-                    prevToken->HasType(Token::NUMBER) && !prevToken->HasType(Token::CONSTANT))) {
+                    m_prevToken.HasType(Token::NUMBER) && !m_prevToken.HasType(Token::CONSTANT))) {
                     return ExpressionError::TWO_CONSECUTIVE_NUMBERS;
                 }
-                
+
                 // There isn't computable left side of binary operator
                 if (token.HasType(Token::BINARY) &&
-                    ((prevToken->HasType(Token::UNARY) && !prevToken->HasType(Token::RIGHT_TO_LEFT)) ||
-                    prevToken->info == 0 || prevToken->HasType(Token::BINARY))) {
+                    ((m_prevToken.HasType(Token::UNARY) && !m_prevToken.HasType(Token::RIGHT_TO_LEFT)) ||
+                    m_prevToken.info == 0 || m_prevToken.HasType(Token::BINARY))) {
                     return ExpressionError::INVALID_OPERATOR_PLACE;
                 }
-                
+
                 // There isn't computable left side of right-to-left unary operator
                 if (token.HasType(Token::UNARY | Token::RIGHT_TO_LEFT) &&
-                    !(prevToken->Is(Token::CLOSE_PAREN) || prevToken->HasType(Token::NUMBER))) {
+                    !(m_prevToken.Is(Token::CLOSE_PAREN) || m_prevToken.HasType(Token::NUMBER))) {
                     return ExpressionError::INVALID_OPERATOR_PLACE;
                 }
 
-                if (token.Is(Token::COMMA) && !prevToken->HasType(Token::NUMBER) &&
-                    !prevToken->Is(Token::CLOSE_PAREN)) {
+                if (token.Is(Token::COMMA) && !m_prevToken.HasType(Token::NUMBER) &&
+                    !m_prevToken.Is(Token::CLOSE_PAREN)) {
                     return ExpressionError::INVALID_COMMA_PLACE;
                 }
 
-                prevToken = &token;
+                m_prevToken = token;
+                return ExpressionError::IS_VALID;
             }
 
-            if (openParen > 0) {
-                return ExpressionError::INVALID_PARENTHESES;
+            // Check after the last token
+            constexpr ExpressionError Finish() const noexcept {
+                return m_openParen > 0 ? ExpressionError::INVALID_PARENTHESES : ExpressionError::IS_VALID;
             }
-            
-            return ExpressionError::IS_VALID;
+
+            // Outermost paren, which isn't closed yet (cause of INVALID_PARENTHESES of Finish)
+            constexpr const Token& GetUnclosedParen() const noexcept { return m_outerParen; }
+
+        private:
+            Token  m_prevToken  = Token(0);
+            Token  m_outerParen = Token(0);
+            size_t m_openParen  = 0;
+        };
+
+    protected:
+        static constexpr CharacterClass _GetCharacterClass(char c) noexcept {
+            return s_CharacterTable[(unsigned char)c].characterClass;
+        }
+
+        // Token info of the builtin function or 0
+        static constexpr uint64_t _FindBuiltin(std::string_view name) noexcept {
+            const BuiltinInfo& builtin = s_BuiltinTable[_HashBuiltin(name)];
+            return builtin.name == name ? builtin.tokenInfo : 0;
         }
 
-        Result<Real, ExpressionError> Evaluate(const char* expression) {
-            std::vector<Token> tokens = Tokenize(expression);
-            std::vector<std::pair<size_t, Token>> implicitTokens = Specify(tokens);
+        // Integer operation ("b" is used by binary ones), false if it isn't closed on integers or overflows.
+        // Zero, which is negative in Real arithmetic (-0, 0*-1), isn't an integer
+        template <typename Integer>
+        static constexpr bool _ApplyInteger(Instruction::OpCode opcode, const Integer& a, const Integer& b, Integer& result) {
+            constexpr Integer min = std::numeric_limits<Integer>::min();
+            constexpr Integer max = std::numeric_limits<Integer>::max();
+
+            auto multiply = [](const Integer& x, const Integer& y, Integer& product) {
+                bool overflows = x > 0 ?
+                    (y > 0 ? x > max / y : y < min / x) :
+                    (y > 0 ? x < min / y : x != 0 && y < max / x);
+                if (!overflows) {
+                    product = x * y;
+                }
+                return !overflows;
+            };
 
-            ExpressionError validateResult = Validate(tokens);
-            if (validateResult != ExpressionError::IS_VALID) {
-                return validateResult;
-            }
-            m_builder.Reset(&tokens, &implicitTokens);
+            switch (opcode) {
+                case Instruction::NEGATE:
+                    if (a == min || a == 0) {
+                        return false;
+                    }
+                    result = -a;
+                    return true;
+                case Instruction::ADD:
+                    if ((b > 0 && a > max - b) || (b < 0 && a < min - b)) {
+                        return false;
+                    }
+                    result = a + b;
+                    return true;
+                case Instruction::SUBTRACT:
+                    if ((b < 0 && a > max + b) || (b > 0 && a < min + b)) {
+                        return false;
+                    }
+                    result = a - b;
+                    return true;
+                case Instruction::MULTIPLY:
+                    if ((a == 0 && b < 0) || (a < 0 && b == 0)) {
+                        return false;
+                    }
+                    return multiply(a, b, result);
 
-            try {
-                std::unique_ptr<_ExprNode> root = m_builder.Build(0);
-                return root->Evaluate();
-            }
-            catch (ExpressionError e) { return e; }
-        };
+                case Instruction::POWER:
+                case Instruction::POW: { // by squaring
+                    if (b < 0) {
+                        return false;
+                    }
 
-    private:
-        Token _ParseNumber(const char* e, size_t& i) const {
-            size_t   left = i;
-            uint64_t info = Token::INTEGER | Token::NUMBER;
+                    Integer power    = 1;
+                    Integer base     = a;
+                    Integer exponent = b;
+                    while (true) {
+                        if ((exponent & 1) && !multiply(power, base, power)) {
+                            return false;
+                        }
+                        exponent >>= 1;
+                        if (exponent == 0) {
+                            break;
+                        }
+                        if (!multiply(base, base, base)) {
+                            return false;
+                        }
+                    }
 
-            while (e[i] != '\0' && isdigit(e[i])) ++i;
-            if (e[i] != '\0' && e[i] == '.') {
-                info &= ~Token::INTEGER;
-                ++i;
+                    result = power;
+                    return true;
+                }
+
+                default: return false;
             }
+        }
 
-            while (e[i] != '\0' && isdigit(e[i])) ++i;
-            if (e[i] != '\0' && e[i] == '.') {
-                return Token();
+        // Integer sum, min or max of "count" values "getValue(i)", false if it isn't one of them or overflows
+        template <typename Integer, typename GetValue>
+        static constexpr bool _AggregateInteger(Instruction::OpCode opcode, size_t count, GetValue getValue, Integer& result) {
+            if (opcode != Instruction::SUM && opcode != Instruction::MIN && opcode != Instruction::MAX) {
+                return false;
             }
 
-            std::string numberString(e + left, e + i);
-            return Token(info, std::make_unique<Token::SpecifiedData<std::string>>(std::move(numberString)));
+            result = getValue(0);
+            for (size_t i = 1; i < count; ++i) {
+                Integer value = getValue(i);
+                switch (opcode) {
+                    case Instruction::SUM:
+                        if (!_ApplyInteger(Instruction::ADD, result, value, result)) {
+                            return false;
+                        }
+                        break;
+                    case Instruction::MIN: result = value < result ? value : result; break;
+                    default:               result = value > result ? value : result; break;
+                }
+            }
+            return true;
         }
 
-        Token _ParseID(const char* e, size_t& i) const {
-            size_t   left = i;
-            uint64_t info = Token::SYMBOL;
+        // Reduction of the aggregate functions (VectorKernels order of operations for any Real, "n" > 0),
+        // from s_ParallelReductionSize values subtrees of the pairwise split are reduced by the default pool
+        template <typename Real>
+        static Real _Reduce(VectorKernels::Reduction reduction, const Real* x, size_t n, const Real& mean = Real(0)) {
+            if (n < s_ParallelReductionSize) {
+                return _ReduceSerial(reduction, x, n, mean);
+            }
 
-            while (e[i] != '\0' && isalpha(e[i])) ++i;
+            std::vector<std::pair<size_t, size_t>> chunks; // begin and size
+            _SplitReduction(0, n, chunks);
 
-            std::string idString(e + left, e + i);
+            std::vector<Real> results(chunks.size());
+            ThreadPool::GetDefault().ParallelForIsolated(chunks.size(), 1, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    results[i] = _ReduceSerial(reduction, x + chunks[i].first, chunks[i].second, mean);
+                }
+            });
 
-            auto constIt = m_constantMap.find(idString);
-            if (constIt != m_constantMap.cend()) {
-                return Token(
-                    info | Token::NUMBER | Token::CONSTANT & ~(Token::SYMBOL),
-                    std::make_unique<Token::SpecifiedData<Real>>(constIt->second)
-                );
-            }
+            const Real* result = results.data();
+            return _CombineReduction(reduction, n, result);
+        }
 
-            auto funcIt = s_FunctionMap.find(idString);
-            if (funcIt != s_FunctionMap.cend()) {
-                return Token(funcIt->second);
+        template <typename Real>
+        static Real _ReduceSerial(VectorKernels::Reduction reduction, const Real* x, size_t n, const Real& mean) {
+            if constexpr (std::is_same_v<Real, double>) {
+                return VectorKernels::Get().reduce(reduction, x, n, mean);
+            }
+            else if constexpr (std::is_same_v<Real, float>) {
+                return VectorKernels::Get().reduceFloat(reduction, x, n, mean);
+            }
+            else {
+                return VectorKernels::ReduceScalar(reduction, x, n, mean);
             }
-
-            return Token();
         }
 
-    private:
-        struct _ExprNode {
-        public:
-            virtual ~_ExprNode() = default;
-            virtual Real Evaluate() const = 0;
-        };
+        // Subtrees of the pairwise split with at most s_ParallelReductionGrain values, in order
+        static void _SplitReduction(size_t begin, size_t n, std::vector<std::pair<size_t, size_t>>& chunks) {
+            if (n <= s_ParallelReductionGrain) {
+                chunks.emplace_back(begin, n);
+                return;
+            }
 
-        template <typename AtomType>
-        struct _AtomNode : _ExprNode {
-        public:
-            _AtomNode() = default;
-            _AtomNode(const AtomType& value) : value(value) {}
-            _AtomNode(AtomType&& value) : value(std::move(value)) {}
+            size_t half = VectorKernels::SplitReduction(n);
+            _SplitReduction(begin, half, chunks);
+            _SplitReduction(begin + half, n - half, chunks);
+        }
 
-            virtual Real Evaluate() const override {
-                return static_cast<Real>(value);
+        // Results of the subtrees combined as in the pairwise split
+        template <typename Real>
+        static Real _CombineReduction(VectorKernels::Reduction reduction, size_t n, const Real*& results) {
+            if (n <= s_ParallelReductionGrain) {
+                return *results++;
             }
 
-        public:
-            AtomType value;
-        };
-
-        struct _UnaryNode : _ExprNode {
-        public:
-            _UnaryNode() = default;
-            _UnaryNode(Real(*func)(const Real&)) : func(func) {}
-            _UnaryNode(Real(*func)(const Real&), std::unique_ptr<_ExprNode>&& arg) : 
-                arg(std::move(arg)), func(func) {}
+            size_t half = VectorKernels::SplitReduction(n);
+            Real   a    = _CombineReduction(reduction, half, results);
+            Real   b    = _CombineReduction(reduction, n - half, results);
+            return VectorKernels::Combine(reduction, a, b);
+        }
 
-            virtual Real Evaluate() const override {
-                return func(arg->Evaluate());
-            };
+        // Perfect hash of the builtin names (collisions are checked at compile time), "name" isn't empty
+        static constexpr size_t _HashBuiltin(std::string_view name) noexcept {
+            return (4 * (unsigned char)name.front() + (unsigned char)name.back() + name.size()) & (s_BuiltinTableSize - 1);
+        }
 
-        public:
-            std::unique_ptr<_ExprNode> arg;
-            Real(*func)(const Real&) = nullptr;
-        };
+    protected:
+        // Remove whitespaces, which don't separate tokens (e.g. "2 * sin x" -> "2*sin x")
+        static void _NormalizeExpression(const char* expression, std::string& result);
 
-        struct _BinaryNode : _ExprNode {
-        public:
-            _BinaryNode() = default;
-            _BinaryNode(
-                std::function<Real(const Real&, const Real&)> func,
-                std::unique_ptr<_ExprNode>&& left,
-                std::unique_ptr<_ExprNode>&& right
-            ) : left(std::move(left)), right(std::move(right)), func(func) {}
-            
-            virtual Real Evaluate() const override {
-                return func(left->Evaluate(), right->Evaluate());
-            };
+        // Offset in "expression" of the char at "normalizedOffset" of its normalized form
+        static size_t _GetSourceOffset(const char* expression, size_t normalizedOffset) noexcept;
 
+    protected:
+#ifdef PARSER_INSTRUMENTATION
+        // Counters are updated with relaxed atomics, because parsers are shared between threads
+        class _Instrumentation {
         public:
-            std::unique_ptr<_ExprNode> left;
-            std::unique_ptr<_ExprNode> right;
-            std::function<Real(const Real&, const Real&)> func;
-        };
+            static constexpr bool s_IsEnabled = true;
 
-        struct _FunctionNode : _ExprNode {
         public:
-            _FunctionNode() = default;
-            _FunctionNode(
-                const std::function<Real(const std::vector<std::unique_ptr<_ExprNode>>&)>& func,
-                std::vector<std::unique_ptr<_ExprNode>>&& args
-            ) : args(std::move(args)), func(func) {};
-
-            virtual Real Evaluate() const override {
-                return func(args);
+            _Instrumentation() = default;
+            _Instrumentation(const _Instrumentation& other) noexcept { _Assign(other.GetSnapshot()); }
+            _Instrumentation& operator=(const _Instrumentation& other) noexcept {
+                _Assign(other.GetSnapshot());
+                return *this;
             }
-            
-        public:
-            std::vector<std::unique_ptr<_ExprNode>> args;
-            std::function<Real(const std::vector<std::unique_ptr<_ExprNode>>&)> func;
-        };
 
-    private:
-        class _Builder {
         public:
-            _Builder() { _InitFunctions(); }
-            _Builder(const Traits& traits) : m_traits(&traits) { _InitFunctions(); }
-
-            _Builder(
-                const std::vector<Token>* tokens,
-                const std::vector<std::pair<size_t, Token>>* implicitTokens
-            ) : m_tokens(tokens), m_implicitTokens(implicitTokens) { _InitFunctions(); }
+            // Measures consecutive stages of one compilation or evaluation
+            class Timer {
+            public:
+                explicit Timer(_Instrumentation& instrumentation) noexcept :
+                m_instrumentation(instrumentation), m_start(_ReadCycles()) {}
 
-        public:
-            std::unique_ptr<_ExprNode> Build(uint8_t rbp) {
-                const Token* token = _Advance();
-                std::unique_ptr<_ExprNode> left = _Nud(token);
-                
-                token = _Get();
-                while (token && !token->HasType(Token::EOEX_LIKE) && rbp < token->GetBP()) {
-                    _Advance();
-                    left = _Led(token, std::move(left));
-                    token = _Get();
+            public:
+                void Lap(Statistics::Stage stage) noexcept {
+                    uint64_t now = _ReadCycles();
+                    m_instrumentation.m_stageCycles[stage].fetch_add(now - m_start, std::memory_order_relaxed);
+                    m_start = now;
                 }
 
-                return std::move(left);
+            private:
+                _Instrumentation& m_instrumentation;
+                uint64_t          m_start;
             };
 
-            void Reset(
-                const std::vector<Token>* tokens,
-                const std::vector<std::pair<size_t, Token>>* implicitTokens
-            ) {
-                m_index = m_implicitIndex = 0;
-                m_tokens = tokens;
-                m_implicitTokens = implicitTokens;
-            }
-
-        private:
-            const Token* _Peek() const {
-                if (m_implicitIndex < m_implicitTokens->size() &&
-                    (*m_implicitTokens)[m_implicitIndex].first == m_index + 1) {
-                    return &((*m_implicitTokens)[m_implicitIndex].second);
-                }
-                if (m_index + 1 < m_tokens->size()) {
-                    return &((*m_tokens)[m_index + 1]);
+        public:
+            // "tokens" is TokenStream of the Parser
+            template <typename Tokens>
+            void RecordCompile(const Tokens& tokens, size_t nodeCount, size_t heapAllocationCount) noexcept {
+                size_t depth     = 0;
+                size_t openParen = 0;
+                for (size_t i = 0; i < tokens.GetSize(); ++i) {
+                    Token token = tokens[i];
+                    if (token.Is(Token::OPEN_PAREN)) {
+                        depth = std::max(depth, ++openParen);
+                    }
+                    else if (token.Is(Token::CLOSE_PAREN) && openParen > 0) {
+                        --openParen;
+                    }
                 }
-                return nullptr;
-            }
 
-            const Token* _Advance() {
-                if (m_implicitIndex < m_implicitTokens->size() &&
-                    (*m_implicitTokens)[m_implicitIndex].first == m_index) {
-                    return &((*m_implicitTokens)[m_implicitIndex++].second);
-                }
-                if (m_index < m_tokens->size()) {
-                    return &((*m_tokens)[m_index++]);
-                }
-                return nullptr;
+                m_compileCount.fetch_add(1, std::memory_order_relaxed);
+                m_tokenCount.fetch_add(tokens.GetSize(), std::memory_order_relaxed);
+                m_nodeCount.fetch_add(nodeCount, std::memory_order_relaxed);
+                m_heapAllocationCount.fetch_add(heapAllocationCount, std::memory_order_relaxed);
+
+                uint64_t maxDepth = m_maxDepth.load(std::memory_order_relaxed);
+                while (depth > maxDepth && !m_maxDepth.compare_exchange_weak(maxDepth, depth, std::memory_order_relaxed));
             }
 
-            const Token* _Get() const {
-                if (m_implicitIndex < m_implicitTokens->size() &&
-                    (*m_implicitTokens)[m_implicitIndex].first == m_index) {
-                    return &((*m_implicitTokens)[m_implicitIndex].second);
-                }
-                if (m_index < m_tokens->size()) {
-                    return &((*m_tokens)[m_index]);
-                }
-                return nullptr;
+            void RecordEvaluation() noexcept { m_evaluationCount.fetch_add(1, std::memory_order_relaxed); }
+
+            void RecordError(ExpressionError error) noexcept {
+                m_errorCounts[(size_t)error].fetch_add(1, std::memory_order_relaxed);
             }
-            
-            // Null denotation (begin of the subexpression)
-            std::unique_ptr<_ExprNode> _Nud(const Token* token) {
-                if (token->HasType(Token::CONSTANT)) {
-                    return std::make_unique<_AtomNode<Real>>(
-                        ((Token::SpecifiedData<Real>*)token->data.get())->value
-                    );
-                }
-                if (token->HasType(Token::NUMBER)) {
-                    const std::string& numberString = ((Token::SpecifiedData<std::string>*)token->data.get())->value;
-                    if (token->HasType(Token::INTEGER)) {
-                        return std::make_unique<_AtomNode<Integer>>(Traits::StringToInteger(numberString));
-                    }
-                    return std::make_unique<_AtomNode<Real>>(Traits::StringToReal(numberString));
-                }
-                if (token->Is(Token::OPEN_PAREN)) {
-                    std::unique_ptr<_ExprNode> expr = Build(0);
-                    _Advance(); // assuming that each open paren has it's own close paren
-                    return std::move(expr);
-                }
-                if (token->HasType(Token::UNARY)) {
-                    std::unique_ptr<_ExprNode> expr = Build(token->GetBP());
-                    return std::make_unique<_UnaryNode>(
-                        m_unaryFunctionMap[token->GetID()],
-                        std::move(expr)
-                    );
-                }
-                if (token->HasType(Token::FUNCTION)) {
-                    size_t argCount = token->GetFunctionArgCount();
-
-                    const Token* next = _Get();
-                    if (next && next->Is(Token::OPEN_PAREN)) {
-                        _Advance(); // skip open paren right after function
-                    }
-                    else {
-                        // call without parentheses for functions with 1 arg (in future)
-                    }
 
-                    std::vector<std::unique_ptr<_ExprNode>> args;
-                    args.reserve(argCount);
+            Statistics GetSnapshot() const noexcept;
+            void Reset() noexcept { _Assign(Statistics()); }
 
-                    const Token* curr = nullptr;
-                    
-                    for (size_t i = 0; i < argCount && !_Get()->Is(Token::CLOSE_PAREN); ++i) {
-                        args.emplace_back(Build(0));
+        private:
+            void _Assign(const Statistics& statistics) noexcept;
 
-                        curr = _Advance();
-                        next = _Get();
-                    }
+            static uint64_t _ReadCycles() noexcept;
 
-                    if (argCount != args.size() || curr->Is(Token::COMMA)) {
-                        throw ExpressionError::INVALID_ARGUMENT_COUNT;
-                    }
+        private:
+            std::atomic<uint64_t> m_stageCycles[Statistics::STAGE_COUNT] = {};
 
-                    return std::make_unique<_FunctionNode>(
-                        _GetFunction(token->GetID()),
-                        std::move(args)
-                    );
-                }
+            std::atomic<uint64_t> m_compileCount{ 0 };
+            std::atomic<uint64_t> m_evaluationCount{ 0 };
+            std::atomic<uint64_t> m_tokenCount{ 0 };
+            std::atomic<uint64_t> m_nodeCount{ 0 };
+            std::atomic<uint64_t> m_maxDepth{ 0 };
+            std::atomic<uint64_t> m_heapAllocationCount{ 0 };
 
-                // Disable warning
-                return std::unique_ptr<_ExprNode>();
+            std::atomic<uint64_t> m_errorCounts[(size_t)ExpressionError::COUNT] = {};
+        };
+#else
+        // Instrumentation is compiled out, all calls are empty
+        class _Instrumentation {
+        public:
+            static constexpr bool s_IsEnabled = false;
+
+        public:
+            class Timer {
+            public:
+                explicit Timer(_Instrumentation&) noexcept {}
+
+            public:
+                void Lap(Statistics::Stage) noexcept {}
+            };
+
+        public:
+            template <typename Tokens>
+            void RecordCompile(const Tokens&, size_t, size_t) noexcept {}
+            void RecordEvaluation() noexcept {}
+            void RecordError(ExpressionError) noexcept {}
+
+            Statistics GetSnapshot() const noexcept { return Statistics(); }
+            void Reset() noexcept {}
+        };
+#endif
+
+    protected:
+        static constexpr size_t s_BuiltinTableSize = 32;
+
+        // Aggregates with fewer arguments are reduced by the calling thread
+        static constexpr size_t s_ParallelReductionSize  = 1 << 16;
+        static constexpr size_t s_ParallelReductionGrain = 1 << 14;
+
+        // Constants declared by every parser
+        // In the widest precision, so each Real gets correctly rounded value
+        static constexpr std::pair<std::string_view, long double> s_BuiltinConstants[] = {
+            { "e",  2.71828182845904523536028747135266250L },
+            { "pi", 3.14159265358979323846264338327950288L }
+        };
+
+        static const std::array<CharacterInfo, 256>              s_CharacterTable;
+        static const std::array<BuiltinInfo, s_BuiltinTableSize> s_BuiltinTable;
+
+    private:
+        static constexpr std::array<CharacterInfo, 256>              _CreateCharacterTable();
+        static constexpr std::array<BuiltinInfo, s_BuiltinTableSize> _CreateBuiltinTable();
+
+        // Isn't constexpr, so collision of builtin name hashes breaks compilation of the table
+        static void _ReportBuiltinHashCollision() noexcept {}
+    };
+
+    constexpr std::array<ParserBase::CharacterInfo, 256> ParserBase::_CreateCharacterTable() {
+        std::array<CharacterInfo, 256> table = {};
+
+        table['\0'].characterClass = END_CHARACTER;
+        for (char c : { ' ', '\t', '\n', '\v', '\f', '\r' }) {
+            table[(unsigned char)c].characterClass = SPACE_CHARACTER;
+        }
+        for (char c = '0'; c <= '9'; ++c) {
+            table[(unsigned char)c].characterClass = DIGIT_CHARACTER;
+        }
+        for (char c = 'a'; c <= 'z'; ++c) {
+            table[(unsigned char)c].characterClass = LETTER_CHARACTER;
+            table[(unsigned char)(c - 'a' + 'A')].characterClass = LETTER_CHARACTER;
+        }
+
+        const std::pair<char, uint64_t> tokens[] = {
+            // operators
+            { '+', CreateOperatorTokenInfo(Token::PLUS,  10, 15) | Token::BINARY | Token::UNARY },
+            { '-', CreateOperatorTokenInfo(Token::MINUS, 10, 15) | Token::BINARY | Token::UNARY },
+            { '*', CreateOperatorTokenInfo(Token::ASTERISK, 20)  | Token::BINARY },
+            { '/', CreateOperatorTokenInfo(Token::SLASH,    20)  | Token::BINARY },
+
+            { '^', CreateOperatorTokenInfo(Token::CARET, 25)     | Token::BINARY },
+
+            // symbols
+            { '(', Token::SYMBOL | (Token::OPEN_PAREN  << Token::ID_BITSHIFT) },
+            { ')', Token::SYMBOL | (Token::CLOSE_PAREN << Token::ID_BITSHIFT) | Token::EOEX_LIKE },
+            { ',', Token::SYMBOL | (Token::COMMA       << Token::ID_BITSHIFT) | Token::EOEX_LIKE }
+        };
+        for (const std::pair<char, uint64_t>& token : tokens) {
+            table[(unsigned char)token.first].characterClass = TOKEN_CHARACTER;
+            table[(unsigned char)token.first].tokenInfo      = token.second;
+        }
+
+        return table;
+    }
+
+    constexpr std::array<ParserBase::BuiltinInfo, ParserBase::s_BuiltinTableSize>
+    ParserBase::_CreateBuiltinTable() {
+        std::array<BuiltinInfo, s_BuiltinTableSize> table = {};
+
+        const BuiltinInfo builtins[] = {
+            { "sqrt", CreateFunctionTokenInfo(Token::SQRT, 1) },
+            { "sin",  CreateFunctionTokenInfo(Token::SIN, 1) },
+            { "cos",  CreateFunctionTokenInfo(Token::COS, 1) },
+            { "tan",  CreateFunctionTokenInfo(Token::TAN, 1) },
+            { "cot",  CreateFunctionTokenInfo(Token::COT, 1) },
+            { "ln",   CreateFunctionTokenInfo(Token::LN,  1) },
+
+            // 2 args
+            { "pow", CreateFunctionTokenInfo(Token::POW, 2) },
+
+            // any arg count
+            { "avg",    CreateFunctionTokenInfo(Token::AVG, 0)    | Token::ANY_ARG_COUNT },
+            { "sum",    CreateFunctionTokenInfo(Token::SUM, 0)    | Token::ANY_ARG_COUNT },
+            { "min",    CreateFunctionTokenInfo(Token::MIN, 0)    | Token::ANY_ARG_COUNT },
+            { "max",    CreateFunctionTokenInfo(Token::MAX, 0)    | Token::ANY_ARG_COUNT },
+            { "stddev", CreateFunctionTokenInfo(Token::STDDEV, 0) | Token::ANY_ARG_COUNT }
+        };
+        for (const BuiltinInfo& builtin : builtins) {
+            BuiltinInfo& slot = table[_HashBuiltin(builtin.name)];
+            if (!slot.name.empty()) {
+                _ReportBuiltinHashCollision();
+            }
+            slot = builtin;
+        }
+
+        return table;
+    }
+
+    // Both tables are built at compile time
+    inline constexpr std::array<ParserBase::CharacterInfo, 256> ParserBase::s_CharacterTable = _CreateCharacterTable();
+    inline constexpr std::array<ParserBase::BuiltinInfo, ParserBase::s_BuiltinTableSize> ParserBase::s_BuiltinTable =
+        _CreateBuiltinTable();
+
+    // Native x86-64 code of the compiled expression (double precision only)
+    class JitFunction {
+    public:
+        using Function = double(*)(const double* variables);
+
+        // Functions called by the generated code
+        struct Calls {
+        public:
+            double(*sqrtFunction)(double) = nullptr;
+            double(*powFunction)(double, double) = nullptr;
+
+            double(*sinFunction)(double) = nullptr;
+            double(*cosFunction)(double) = nullptr;
+            double(*tanFunction)(double) = nullptr;
+            double(*cotFunction)(double) = nullptr; // optional
+
+            double(*lnFunction)(double) = nullptr;
+        };
+
+    public:
+        JitFunction() = default;
+        JitFunction(JitFunction&& other) noexcept;
+        ~JitFunction();
+
+        JitFunction(const JitFunction&) = delete;
+        JitFunction& operator=(const JitFunction&) = delete;
+        JitFunction& operator=(JitFunction&& other) noexcept;
+
+    public:
+        // Empty function, if JIT isn't supported on the platform, program is too deep or has min, max, stddev
+        // or sum and avg of more than VectorKernels::REDUCTION_BLOCK_SIZE arguments
+        static JitFunction Compile(
+            const ParserBase::Instruction* code,
+            size_t codeSize,
+            const double* constants,
+            size_t stackSize,
+            const Calls& calls
+        );
+
+        static bool IsSupported() noexcept;
+
+    public:
+        Function Get() const noexcept { return m_function; }
+        size_t GetSize() const noexcept { return m_size; }
+        explicit operator bool() const noexcept { return m_function != nullptr; }
+
+    private:
+        void _Free() noexcept;
+
+    private:
+        Function m_function = nullptr;
+        void*    m_memory   = nullptr;
+        size_t   m_size     = 0;
+    };
+
+    template <typename Traits = ParserBase::DefaultTraits>
+    class Parser : public ParserBase {
+    public:
+        using Integer = typename Traits::Integer;
+        using Real    = typename Traits::Real;
+
+    private:
+        struct _ExprNode;
+        struct _Program;
+        struct _SetProgram;
+
+        class _Builder;
+
+        // Value of the token, which is stored in TokenStream
+        struct _Payload {
+        public:
+            Real     real    = Real();
+            Integer  integer = Integer();
+            uint32_t index   = 0;
+        };
+
+    public:
+        class CompiledExpression {
+        public:
+            CompiledExpression() = default;
+
+        public:
+            // "variables" must contain at least GetVariableCount() values
+            Real Evaluate(const Real* variables = nullptr) const {
+                if constexpr (std::is_same_v<Real, double>) {
+                    if (m_program->jit) {
+                        return m_program->jit.Get()(variables);
+                    }
+                }
+                return _Run(*m_program, variables);
+            }
+
+            // "columns[slot]" points to "rowCount" values of the variable, "results" receives "rowCount" values
+            void EvaluateBatch(const Real* const* columns, size_t rowCount, Real* results) const {
+                _RunBatch(*m_program, columns, rowCount, results);
+            }
+
+            // Value and its partial derivatives by reverse-mode differentiation (one forward and one backward sweep),
+            // "gradient" receives GetVariableCount() values
+            Real EvaluateGradient(const Real* variables, Real* gradient) const {
+                return _RunGradient(*m_program, variables, gradient);
+            }
+
+            // Evaluate through the expression tree, available only if compiled with KEEP_TREE flag
+            Real EvaluateTree(const Real* variables = nullptr) const {
+                return _EvaluateTree(*m_program, variables);
+            }
+
+            bool HasTree() const noexcept { return m_program->tree != nullptr; }
+
+            // Native code of the program, available only if compiled with ENABLE_JIT flag (nullptr otherwise)
+            JitFunction::Function GetNativeFunction() const noexcept { return m_program->jit.Get(); }
+
+            // Minimal size of the value array (the highest used variable slot + 1)
+            size_t GetVariableCount() const noexcept { return m_program->variableCount; }
+
+            const std::vector<Instruction>& GetCode()      const noexcept { return m_program->code; }
+            const std::vector<Real>&        GetConstants() const noexcept { return m_program->constants; }
+
+            // Count of stack values needed by the code
+            size_t GetStackSize() const noexcept { return m_program->stackSize; }
+
+            // Expression has only integer literals, +, -, * and ^ with non-negative exponents,
+            // and its value fits Integer (GetIntegerValue is exact, while Evaluate rounds it to Real)
+            bool    IsInteger()       const noexcept { return m_program->isInteger; }
+            Integer GetIntegerValue() const noexcept { return m_program->integerValue; }
+
+            // Approximate count of bytes taken by the program
+            size_t GetMemoryUsage() const noexcept {
+                return sizeof(_Program) + m_program->treeArena.GetUsedBytes() + m_program->jit.GetSize() +
+                    m_program->code.capacity() * sizeof(Instruction) +
+                    m_program->constants.capacity() * sizeof(Real);
+            }
+
+        private:
+            friend class Parser;
+
+            CompiledExpression(std::shared_ptr<const _Program>&& program) : m_program(std::move(program)) {}
+
+        private:
+            std::shared_ptr<const _Program> m_program;
+        };
+
+        // Several expressions compiled into one program, structurally equal subexpressions are computed once
+        class CompiledSet {
+        public:
+            CompiledSet() = default;
+
+        public:
+            // "variables" must contain at least GetVariableCount() values,
+            // "results" receives GetExpressionCount() values in order of the expressions
+            void Evaluate(const Real* variables, Real* results) const {
+                _RunSet(*m_program, variables, results);
+            }
+
+            size_t GetExpressionCount() const noexcept { return m_program->outputs.size(); }
+
+            // Minimal size of the value array (the highest used variable slot + 1)
+            size_t GetVariableCount() const noexcept { return m_program->variableCount; }
+
+            // Count of distinct subexpressions (instructions of the shared program)
+            size_t GetNodeCount() const noexcept { return m_program->code.size(); }
+
+        private:
+            friend class Parser;
+            friend class IncrementalSet;
+
+            CompiledSet(std::shared_ptr<const _SetProgram>&& program) : m_program(std::move(program)) {}
+
+        private:
+            std::shared_ptr<const _SetProgram> m_program;
+        };
+
+        // Values of a compiled set cached between updates of the variables: only subexpressions depending on
+        // changed variables are recomputed. Isn't thread-safe
+        class IncrementalSet {
+        public:
+            IncrementalSet() = default;
+
+            // Evaluate whole set once, "variables" must contain at least set.GetVariableCount() values
+            IncrementalSet(const CompiledSet& set, const Real* variables) :
+            m_program(set.m_program),
+            m_variables(variables, variables + m_program->variableCount),
+            m_values(m_program->code.size()),
+            m_isQueued(m_program->code.size(), false),
+            m_variableInstructions(m_program->variableCount, s_NoInstruction) {
+                const _SetProgram& program = *m_program;
+
+                // Argument offsets and instructions using each instruction (grouped by the used instruction)
+                m_argumentOffsets.resize(program.code.size() + 1);
+                m_userOffsets.assign(program.code.size() + 1, 0);
+
+                uint32_t offset = 0;
+                for (size_t i = 0; i < program.code.size(); ++i) {
+                    m_argumentOffsets[i] = offset;
+                    offset += (uint32_t)program.code[i].GetArgCount();
+
+                    if (program.code[i].opcode == Instruction::PUSH_VARIABLE) {
+                        m_variableInstructions[program.code[i].operand] = (uint32_t)i;
+                    }
+                }
+                m_argumentOffsets.back() = offset;
+
+                for (uint32_t arg : program.arguments) {
+                    ++m_userOffsets[arg + 1];
+                }
+                for (size_t i = 1; i < m_userOffsets.size(); ++i) {
+                    m_userOffsets[i] += m_userOffsets[i - 1];
+                }
+
+                m_users.resize(program.arguments.size());
+                std::vector<uint32_t> userCounts(program.code.size(), 0);
+                for (size_t i = 0; i < program.code.size(); ++i) {
+                    for (uint32_t a = m_argumentOffsets[i]; a < m_argumentOffsets[i + 1]; ++a) {
+                        uint32_t arg = program.arguments[a];
+                        m_users[m_userOffsets[arg] + userCounts[arg]++] = (uint32_t)i;
+                    }
+                }
+
+                for (size_t i = 0; i < program.code.size(); ++i) {
+                    m_values[i] = _Recompute(i);
+                }
+            }
+
+        public:
+            // New value is used by the next Update
+            void SetVariable(size_t slot, const Real& value) {
+                if (!_IsChanged(m_variables[slot], value)) {
+                    return;
+                }
+                m_variables[slot] = value;
+
+                uint32_t instruction = m_variableInstructions[slot];
+                if (instruction != s_NoInstruction && !m_isQueued[instruction]) {
+                    m_isQueued[instruction] = true;
+                    m_queue.push(instruction);
+                }
+            }
+
+            // Recompute dirty instructions in order of the program (arguments go before their users),
+            // propagation stops at unchanged values. Returns count of recomputed instructions
+            size_t Update() {
+                size_t recomputedCount = 0;
+
+                while (!m_queue.empty()) {
+                    uint32_t i = m_queue.top();
+                    m_queue.pop();
+                    m_isQueued[i] = false;
+
+                    Real value = _Recompute(i);
+                    ++recomputedCount;
+
+                    if (!_IsChanged(m_values[i], value)) {
+                        continue;
+                    }
+                    m_values[i] = value;
+
+                    for (uint32_t u = m_userOffsets[i]; u < m_userOffsets[i + 1]; ++u) {
+                        uint32_t user = m_users[u];
+                        if (!m_isQueued[user]) {
+                            m_isQueued[user] = true;
+                            m_queue.push(user);
+                        }
+                    }
+                }
+
+                return recomputedCount;
+            }
+
+            // Value of the expression after the last Update
+            const Real& GetResult(size_t index) const { return m_values[m_program->outputs[index]]; }
+
+            size_t GetExpressionCount() const noexcept { return m_program->outputs.size(); }
+            size_t GetVariableCount()   const noexcept { return m_variables.size(); }
+
+        private:
+            static constexpr uint32_t s_NoInstruction = UINT32_MAX;
+
+            Real _Recompute(size_t i) {
+                const Instruction& instruction = m_program->code[i];
+
+                switch (instruction.opcode) {
+                    case Instruction::PUSH_CONSTANT: return m_program->constants[instruction.operand];
+                    case Instruction::PUSH_VARIABLE: return m_variables[instruction.operand];
+
+                    default: {
+                        m_arguments.clear();
+                        for (uint32_t a = m_argumentOffsets[i]; a < m_argumentOffsets[i + 1]; ++a) {
+                            m_arguments.push_back(m_values[m_program->arguments[a]]);
+                        }
+                        return _Apply(instruction.opcode, m_arguments.data(), m_arguments.size(), m_program->traits);
+                    }
+                }
+            }
+
+            // Zeros of different sign are different values, NaN is always changed
+            static bool _IsChanged(const Real& oldValue, const Real& newValue) {
+                return !(oldValue == newValue) || _IsNegativeZero(oldValue) != _IsNegativeZero(newValue);
+            }
+
+        private:
+            std::shared_ptr<const _SetProgram> m_program;
+
+            std::vector<Real> m_variables;
+            std::vector<Real> m_values;    // value of each instruction
+            std::vector<Real> m_arguments; // scratch for argument values
+
+            std::vector<bool>     m_isQueued;
+            std::vector<uint32_t> m_variableInstructions; // instruction of each variable slot
+            std::vector<uint32_t> m_argumentOffsets;      // in the arguments of the program
+            std::vector<uint32_t> m_userOffsets;          // in m_users
+            std::vector<uint32_t> m_users;
+
+            std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<uint32_t>> m_queue;
+        };
+
+        // Tokens of one expression packed for parsing: one 32-bit word per token (type, ID and binding powers).
+        // Payloads are kept in token order in the array of their kind: reals (constants and real numbers),
+        // integers, and indices (variable slots and function arg counts). Arrays are allocated in the arena
+        // passed to the tokenizer, token spans are found again from the expression only for errors
+        class TokenStream {
+        public:
+            TokenStream() = default;
+
+        public:
+            size_t GetSize() const noexcept { return m_words.size; }
+
+            // Token without its source span and arg count
+            Token operator[](size_t index) const noexcept { return Token(m_words.data[index]); }
+
+            // Bytes taken by the words and payloads
+            size_t GetMemoryUsage() const noexcept {
+                return m_words.capacity * sizeof(uint32_t) + m_reals.capacity * sizeof(Real) +
+                    m_integers.capacity * sizeof(Integer) + m_indices.capacity * sizeof(uint32_t);
+            }
+
+        private:
+            // Growable array in the arena (outgrown storage is left to the arena)
+            template <typename T>
+            struct _Array {
+            public:
+                void Push(Arena& arena, const T& value) {
+                    if (size == capacity) {
+                        Reserve(arena, std::max<size_t>(capacity * 2, 8));
+                    }
+                    data[size++] = value;
+                }
+
+                void Reserve(Arena& arena, size_t newCapacity) {
+                    if (newCapacity > capacity) {
+                        T* newData = arena.CreateArray<T>(newCapacity);
+                        std::copy(data, data + size, newData);
+
+                        data     = newData;
+                        capacity = newCapacity;
+                    }
+                }
+
+            public:
+                T*     data     = nullptr;
+                size_t size     = 0;
+                size_t capacity = 0;
+            };
+
+            enum _PayloadKind {
+                NO_PAYLOAD,
+                REAL_PAYLOAD,
+                INTEGER_PAYLOAD,
+                INDEX_PAYLOAD
+            };
+
+        private:
+            static constexpr _PayloadKind _GetPayloadKind(const Token& token) noexcept {
+                if (token.HasType(Token::VARIABLE) || token.HasType(Token::FUNCTION)) {
+                    return INDEX_PAYLOAD;
+                }
+                if (token.HasType(Token::NUMBER)) {
+                    return token.HasType(Token::INTEGER) ? INTEGER_PAYLOAD : REAL_PAYLOAD;
+                }
+                return NO_PAYLOAD;
+            }
+
+            // Drop the tokens and storage (arena could be reset since the last use)
+            void _Reset(const char* expression, Arena& arena, size_t wordCapacity) {
+                *this = TokenStream();
+                m_expression = expression;
+                m_arena      = &arena;
+                m_words.Reserve(arena, wordCapacity);
+            }
+
+            void _Push(const Token& token, const _Payload& payload) {
+                m_words.Push(*m_arena, (uint32_t)token.info);
+                switch (_GetPayloadKind(token)) {
+                    case REAL_PAYLOAD:    m_reals.Push(*m_arena, payload.real); break;
+                    case INTEGER_PAYLOAD: m_integers.Push(*m_arena, payload.integer); break;
+                    case INDEX_PAYLOAD:   m_indices.Push(*m_arena, payload.index); break;
+                    default: break;
+                }
+            }
+
+        private:
+            _Array<uint32_t> m_words;
+            _Array<Real>     m_reals;
+            _Array<Integer>  m_integers;
+            _Array<uint32_t> m_indices;
+
+            const char* m_expression = nullptr; // source of the token spans
+            Arena*      m_arena      = nullptr;
+
+            friend class Parser;
+            friend class _Builder;
+        };
+
+    public:
+        Parser() : Parser(Traits()) {}
+        Parser(const Traits& traits, uint64_t flags = 0) : m_flags(flags), m_traits(traits) {
+            for (const std::pair<std::string_view, long double>& constant : s_BuiltinConstants) {
+                DeclareConstant(constant.first, Real(constant.second));
+            }
+        }
+
+    public:
+        // Tokenize, specify and validate in one pass, implicit multiplications are inserted in-line.
+        // Tokens are allocated in "arena", "expression" must outlive them (it's read again for error positions)
+        ErrorInfo Scan(const char* expression, Arena& arena, TokenStream& tokens) const {
+            tokens._Reset(expression, arena, strlen(expression) / 2 + 2); // tokens are mostly separated
+
+            _Specifier specifier;
+            _Validator validator;
+
+            auto setArgCount = [&tokens](size_t index, size_t argCount) {
+                tokens.m_indices.data[index] = (uint32_t)argCount;
+            };
+
+            size_t i = 0;
+            while (true) {
+                _Payload payload;
+                Token    token = _NextToken(expression, i, payload);
+                if (token.info == 0) {
+                    return _GetError(ExpressionError::INVALID_TOKEN, token);
+                }
+
+                if (specifier.IsImplicitMultiplication(token)) {
+                    Token multiplication(s_CharacterTable['*'].tokenInfo, token.offset, 0);
+                    specifier.Specify(multiplication, 0, setArgCount);
+                    validator.Validate(multiplication); // always valid after operand
+                    tokens._Push(multiplication, payload);
+                }
+
+                // index of the payload, which the token is going to take
+                specifier.Specify(token, tokens.m_indices.size, setArgCount);
+                tokens._Push(token, payload);
+
+                ExpressionError error = validator.Validate(token);
+                if (error != ExpressionError::IS_VALID) {
+                    return _GetError(error, token);
+                }
+
+                if (token.Is(Token::EOEX)) {
+                    return _GetError(validator.Finish(), validator.GetUnclosedParen());
+                }
+            }
+        }
+
+        // Tokens are allocated in "arena", "tokens" is empty, if there is invalid token
+        ErrorInfo Tokenize(const char* expression, Arena& arena, TokenStream& tokens) const {
+            tokens._Reset(expression, arena, strlen(expression) / 2 + 2); // tokens are mostly separated
+
+            size_t i = 0;
+            while (true) {
+                _Payload payload;
+                Token    token = _NextToken(expression, i, payload);
+                if (token.info == 0) {
+                    tokens._Reset(expression, arena, 0);
+                    return _GetError(ExpressionError::INVALID_TOKEN, token);
+                }
+
+                tokens._Push(token, payload);
+                if (token.Is(Token::EOEX)) {
+                    return ErrorInfo();
+                }
+            }
+        };
+
+        // Specify operators (some operators depend on context) and function arg count, insert implicit tokens.
+        // Payloads stay in place, words are copied to the new array in the arena of the tokens
+        void Specify(TokenStream& tokens) const {
+            if (tokens.GetSize() == 0) {
+                return;
+            }
+
+            typename TokenStream::template _Array<uint32_t> words;
+            words.Reserve(*tokens.m_arena, tokens.m_words.size + tokens.m_words.size / 2);
+
+            auto setArgCount = [&tokens](size_t index, size_t argCount) {
+                tokens.m_indices.data[index] = (uint32_t)argCount;
+            };
+
+            _Specifier specifier;
+            size_t     index = 0; // of the next index payload
+            for (size_t i = 0; i < tokens.GetSize(); ++i) {
+                Token token = tokens[i];
+                if (specifier.IsImplicitMultiplication(token)) {
+                    Token multiplication(s_CharacterTable['*'].tokenInfo);
+                    specifier.Specify(multiplication, 0, setArgCount);
+                    words.Push(*tokens.m_arena, (uint32_t)multiplication.info);
+                }
+
+                specifier.Specify(token, index, setArgCount);
+                words.Push(*tokens.m_arena, (uint32_t)token.info);
+                index += TokenStream::_GetPayloadKind(token) == TokenStream::INDEX_PAYLOAD;
+            }
+            tokens.m_words = words;
+        }
+
+        // Check, if expression tokens are compatible
+        ErrorInfo Validate(const TokenStream& tokens) const {
+            _Validator validator;
+
+            size_t depth         = 0;
+            size_t unclosedParen = 0; // outermost open paren, which isn't closed yet
+            for (size_t i = 0; i < tokens.GetSize(); ++i) {
+                Token token = tokens[i];
+
+                ExpressionError error = validator.Validate(token);
+                if (error != ExpressionError::IS_VALID) {
+                    return _LocateError(error, tokens, i);
+                }
+
+                if (token.Is(Token::OPEN_PAREN) && depth++ == 0) {
+                    unclosedParen = i;
+                }
+                else if (token.Is(Token::CLOSE_PAREN)) {
+                    --depth;
+                }
+            }
+
+            ExpressionError error = validator.Finish();
+            return error == ExpressionError::IS_VALID ? ErrorInfo() : _LocateError(error, tokens, unclosedParen);
+        }
+
+        // Emit program of tokens, which passed Scan (or Specify and Validate)
+        Result<CompiledExpression, ErrorInfo> Build(const TokenStream& tokens) const {
+            std::shared_ptr<_Program> program = std::make_shared<_Program>(m_traits);
+            program->code.reserve(tokens.GetSize());
+            _Builder builder(&tokens, program.get(), m_depthLimit);
+
+            builder.Build();
+            builder.Finish();
+            if (builder.GetError() != ExpressionError::IS_VALID) {
+                return _LocateError(builder.GetError(), tokens, builder.GetErrorToken());
+            }
+
+            // typing isn't optimization, it defines results of integer arithmetic
+            _FoldIntegers(*program, builder.GetIntegerConstants());
+
+            if (!(m_flags & DISABLE_OPTIMIZATION)) {
+                _Optimize(*program, m_flags);
+            }
+            if (m_flags & KEEP_TREE) {
+                program->tree = _BuildTree(*program);
+            }
+            if (m_flags & ENABLE_JIT) {
+                _CompileNative(*program);
+            }
+            return CompiledExpression(std::move(program));
+        }
+
+        // Parse expression once, result can be evaluated many times with different variable values.
+        // Compile and evaluation are thread-safe, compiled expressions are immutable and can be shared between threads
+        Result<CompiledExpression, ErrorInfo> Compile(const char* expression) const {
+            // parse data of short expressions fits on the stack, long ones take one block (tokens are under 8 bytes per char)
+            alignas(std::max_align_t) char buffer[s_ScratchBufferSize];
+            Arena arena(buffer, sizeof(buffer), std::max(Arena::DEFAULT_BLOCK_SIZE, strlen(expression) * 8));
+            return Compile(expression, arena);
+        }
+
+        // Use caller-supplied arena for parse data (reset of the arena is up to the caller)
+        Result<CompiledExpression, ErrorInfo> Compile(const char* expression, Arena& arena) const {
+            Result<CompiledExpression, ErrorInfo> result;
+            if (!m_cache) {
+                result = _Compile(expression, arena);
+            }
+            else {
+                std::string key;
+                _NormalizeExpression(expression, key);
+
+                // key is compiled, so cached errors are located in the key
+                if (!m_cache->Find(key, result)) {
+                    result = _Compile(key.c_str(), arena);
+                    m_cache->Insert(key, result);
+                }
+                if (!result.HasValue()) {
+                    ErrorInfo error = result.Error();
+                    error.offset = (uint32_t)_GetSourceOffset(expression, error.offset);
+                    result = error;
+                }
+            }
+
+            if (!result.HasValue()) {
+                m_instrumentation.RecordError(result.Error());
+            }
+            return result;
+        }
+
+        // Compile expressions into one shared program, fails with the error of the first invalid expression
+        Result<CompiledSet, ErrorInfo> CompileSet(const char* const* expressions, size_t count) const {
+            std::vector<CompiledExpression> compiled;
+            compiled.reserve(count);
+
+            for (size_t i = 0; i < count; ++i) {
+                Result<CompiledExpression, ErrorInfo> result = Compile(expressions[i]);
+                if (!result.HasValue()) {
+                    return result.Error();
+                }
+                compiled.emplace_back(result.Get());
+            }
+            return Merge(compiled.data(), compiled.size());
+        }
+
+        // Merge expressions compiled by the same parser (subexpressions are matched after optimization)
+        static CompiledSet Merge(const CompiledExpression* expressions, size_t count) {
+            return CompiledSet(_Merge(expressions, count));
+        }
+
+        // "variables" must contain at least GetVariableCount() values, if expression uses variables
+        Result<Real, ErrorInfo> Evaluate(const char* expression, const Real* variables = nullptr) const {
+            Result<CompiledExpression, ErrorInfo> compiled = Compile(expression);
+            if (!compiled.HasValue()) {
+                return compiled.Error();
+            }
+            if (!variables && compiled.Get().GetVariableCount() > 0) {
+                m_instrumentation.RecordError(ExpressionError::UNBOUND_VARIABLE);
+                return _GetUnboundVariableError(expression);
+            }
+
+            _Instrumentation::Timer timer(m_instrumentation);
+            Real result = compiled.Get().Evaluate(variables);
+            timer.Lap(Statistics::EVALUATE);
+
+            m_instrumentation.RecordEvaluation();
+            return result;
+        };
+
+        // Run code, which was validated elsewhere (e.g. loaded by ExpressionFile), with the traits of the parser.
+        // Operands of the code must be in range of "constants" and "variables", "stackSize" must fit the code
+        Real EvaluateProgram(
+            const Instruction* code,
+            size_t codeSize,
+            const Real* constants,
+            size_t stackSize,
+            const Real* variables = nullptr
+        ) const {
+            return _Run(code, codeSize, constants, stackSize, variables, m_traits);
+        }
+
+        struct Job {
+        public:
+            const char* expression = nullptr;
+            const Real* variables  = nullptr;
+        };
+
+        struct CompiledJob {
+        public:
+            const CompiledExpression* expression = nullptr;
+            const Real*               variables  = nullptr;
+        };
+
+        // Evaluate jobs on the threads of "pool", "results" receives "jobCount" values
+        void EvaluateParallel(
+            const Job* jobs,
+            size_t jobCount,
+            Result<Real, ErrorInfo>* results,
+            ThreadPool& pool = ThreadPool::GetDefault()
+        ) const {
+            pool.ParallelFor(jobCount, s_ParallelGrain, [this, jobs, results](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    results[i] = Evaluate(jobs[i].expression, jobs[i].variables);
+                }
+            });
+        }
+
+        static void EvaluateParallel(
+            const CompiledJob* jobs,
+            size_t jobCount,
+            Real* results,
+            ThreadPool& pool = ThreadPool::GetDefault()
+        ) {
+            pool.ParallelFor(jobCount, s_ParallelGrain, [jobs, results](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    results[i] = jobs[i].expression->Evaluate(jobs[i].variables);
+                }
+            });
+        }
+
+    public:
+        // Configuration isn't thread-safe, it must be done before parser is shared between threads.
+        // Returns slot of the variable in the value array passed to evaluation
+        size_t DeclareVariable(std::string_view name) {
+            _IdentifierTable::Entry& entry = m_identifierTable.Insert(name);
+            if (entry.info & Token::VARIABLE) {
+                return entry.index;
+            }
+
+            // variable hides constant with the same name
+            entry.info  = Token::NUMBER | Token::CONSTANT | Token::VARIABLE;
+            entry.index = m_variableCount++;
+
+            // cached results could have been compiled without this variable
+            if (m_cache) {
+                m_cache->Clear();
+            }
+            return entry.index;
+        }
+
+        size_t GetVariableCount() const noexcept { return m_variableCount; }
+
+        // Redeclaration changes value of the constant or hides variable with the same name
+        void DeclareConstant(std::string_view name, Real value) {
+            _IdentifierTable::Entry& entry = m_identifierTable.Insert(name);
+            if (entry.info != 0 && !(entry.info & Token::VARIABLE)) {
+                m_constants[entry.index] = value;
+            }
+            else {
+                entry.info  = Token::SYMBOL | Token::NUMBER | Token::CONSTANT;
+                entry.index = m_constants.size();
+                m_constants.push_back(value);
+            }
+
+            if (m_cache) {
+                m_cache->Clear();
+            }
+        }
+
+        void SetFlags(uint64_t flags) {
+            if (m_cache && flags != m_flags) {
+                m_cache->Clear();
+            }
+            m_flags = flags;
+        }
+
+        uint64_t GetFlags() const noexcept { return m_flags; }
+
+        // Maximum nesting of subexpressions (parentheses, function arguments, operands of operators),
+        // deeper expressions fail with TOO_DEEP
+        void SetDepthLimit(size_t depthLimit) {
+            if (m_cache && depthLimit != m_depthLimit) {
+                m_cache->Clear();
+            }
+            m_depthLimit = depthLimit;
+        }
+
+        size_t GetDepthLimit() const noexcept { return m_depthLimit; }
+
+    public:
+        // Cache compiled expressions and errors by normalized expression text,
+        // least recently used entries are evicted when cache takes more than "byteBudget" bytes
+        void EnableCache(size_t byteBudget) {
+            if (!m_cache) {
+                m_cache = std::make_unique<_Cache>();
+            }
+            m_cache->SetByteBudget(byteBudget);
+        }
+
+        void DisableCache() noexcept { m_cache.reset(); }
+
+        // Snapshot of the counters (zeros if built without PARSER_INSTRUMENTATION)
+        Statistics GetStatistics() const noexcept { return m_instrumentation.GetSnapshot(); }
+        void ResetStatistics() noexcept { m_instrumentation.Reset(); }
+
+        CacheStatistics GetCacheStatistics() const noexcept {
+            return m_cache ? m_cache->GetStatistics() : CacheStatistics();
+        }
+
+        void ResetCacheStatistics() noexcept {
+            if (m_cache) {
+                m_cache->ResetStatistics();
+            }
+        }
+
+    private:
+        Result<CompiledExpression, ErrorInfo> _Compile(const char* expression, Arena& arena) const {
+            _Instrumentation::Timer timer(m_instrumentation);
+            size_t arenaAllocationCount = arena.GetAllocationCount();
+
+            TokenStream tokens;
+            ErrorInfo   scanResult = Scan(expression, arena, tokens);
+            timer.Lap(Statistics::SCAN);
+            if (scanResult.code != ExpressionError::IS_VALID) {
+                return scanResult;
+            }
+
+            Result<CompiledExpression, ErrorInfo> result = Build(tokens);
+            timer.Lap(Statistics::BUILD);
+
+            if constexpr (_Instrumentation::s_IsEnabled) {
+                size_t nodeCount           = 0;
+                size_t heapAllocationCount = arena.GetAllocationCount() - arenaAllocationCount;
+
+                if (result.HasValue()) {
+                    const _Program& program = *result.Get().m_program;
+
+                    nodeCount = program.code.size();
+                    heapAllocationCount += 1 + program.treeArena.GetAllocationCount() +
+                        (program.code.capacity() > 0) + (program.constants.capacity() > 0);
+                }
+                m_instrumentation.RecordCompile(tokens, nodeCount, heapAllocationCount);
+            }
+            return result;
+        }
+
+        static constexpr ErrorInfo _GetError(ExpressionError error, const Token& token) noexcept {
+            return error == ExpressionError::IS_VALID ? ErrorInfo() : ErrorInfo(error, token.offset, token.length);
+        }
+
+        // Span of the first variable of valid expression (only on the error path)
+        ErrorInfo _GetUnboundVariableError(const char* expression) const {
+            size_t i = 0;
+            while (true) {
+                _Payload payload;
+                Token    token = _NextToken(expression, i, payload);
+                if (token.HasType(Token::VARIABLE)) {
+                    return _GetError(ExpressionError::UNBOUND_VARIABLE, token);
+                }
+                if (token.info == 0 || token.Is(Token::EOEX)) {
+                    return ExpressionError::UNBOUND_VARIABLE;
+                }
+            }
+        }
+
+        // Span of the token "index" of specified "tokens", which is found by tokenizing their expression again
+        ErrorInfo _LocateError(ExpressionError error, const TokenStream& tokens, size_t index) const {
+            _Specifier specifier;
+            size_t     i     = 0;
+            size_t     count = 0;
+
+            auto ignoreArgCount = [](size_t, size_t) {};
+
+            while (tokens.m_expression) {
+                _Payload payload;
+                Token    token = _NextToken(tokens.m_expression, i, payload);
+                if (token.info == 0) {
+                    break;
+                }
+
+                if (specifier.IsImplicitMultiplication(token)) {
+                    Token multiplication(s_CharacterTable['*'].tokenInfo, token.offset, 0);
+                    specifier.Specify(multiplication, 0, ignoreArgCount);
+                    if (count++ == index) {
+                        return _GetError(error, multiplication);
+                    }
+                }
+
+                specifier.Specify(token, 0, ignoreArgCount);
+                if (count++ == index || token.Is(Token::EOEX)) {
+                    return _GetError(error, token);
+                }
+            }
+            return error;
+        }
+
+        // Skip spaces and read one token (EOEX at the end of expression, empty token if it's invalid)
+        Token _NextToken(const char* expression, size_t& i, _Payload& payload) const {
+            const CharacterInfo* character = &s_CharacterTable[(unsigned char)expression[i]];
+            while (character->characterClass == SPACE_CHARACTER) {
+                character = &s_CharacterTable[(unsigned char)expression[++i]];
+            }
+
+            size_t begin = i;
+            Token  token;
+
+            switch (character->characterClass) {
+                case END_CHARACTER:
+                    return Token(Token::SYMBOL | (Token::EOEX << Token::ID_BITSHIFT) | Token::EOEX_LIKE, (uint32_t)i, 0);
+
+                case DIGIT_CHARACTER: // number
+                    token = _ParseNumber(expression, i, payload);
+                    break;
+
+                case LETTER_CHARACTER: // constant, variable, function
+                    token = _ParseID(expression, i, payload);
+                    break;
+
+                case TOKEN_CHARACTER: // operator, symbol
+                    token.info = character->tokenInfo;
+                    ++i;
+                    break;
+
+                default:
+                    return Token(0, (uint32_t)i, 1);
+            }
+
+            token.offset = (uint32_t)begin;
+            token.length = (uint32_t)(i - begin);
+            return token;
+        }
+
+        Token _ParseNumber(const char* e, size_t& i, _Payload& payload) const {
+            size_t   left = i;
+            uint64_t info = Token::INTEGER | Token::NUMBER;
+
+            while (_GetCharacterClass(e[i]) == DIGIT_CHARACTER) ++i;
+            if (e[i] == '.') {
+                info &= ~Token::INTEGER;
+                ++i;
+            }
+
+            while (_GetCharacterClass(e[i]) == DIGIT_CHARACTER) ++i;
+            if (e[i] == '.') {
+                return Token();
+            }
+
+            std::string_view numberString(e + left, i - left);
+
+            if ((info & Token::INTEGER) && Traits::StringToInteger(numberString, payload.integer)) {
+                return Token(info);
+            }
+
+            // too big integer is still valid real number
+            if (Traits::StringToReal(numberString, payload.real)) {
+                return Token(info & ~Token::INTEGER);
+            }
+            return Token();
+        }
+
+        Token _ParseID(const char* e, size_t& i, _Payload& payload) const {
+            size_t left = i;
+            while (_GetCharacterClass(e[i]) == LETTER_CHARACTER) ++i;
+
+            std::string_view idString(e + left, i - left);
+
+            const _IdentifierTable::Entry* entry = m_identifierTable.Find(idString);
+            if (entry) {
+                if (entry->info & Token::VARIABLE) {
+                    payload.index = (uint32_t)entry->index;
+                }
+                else {
+                    payload.real = m_constants[entry->index];
+                }
+                return Token(entry->info);
+            }
+
+            Token function(_FindBuiltin(idString));
+            payload.index = (uint32_t)function.GetFunctionArgCount();
+            return function;
+        }
+
+    private:
+        static constexpr size_t s_LocalStackSize    = 64;
+        static constexpr size_t s_ScratchBufferSize = 2048;
+        static constexpr size_t s_ParallelGrain     = 64;
+
+        // Apply any non-push instruction to its arguments
+        static Real _Apply(Instruction::OpCode opcode, const Real* args, size_t argCount, const Traits& traits) {
+            switch (opcode) {
+                case Instruction::NEGATE:   return -args[0];
+                case Instruction::ADD:      return args[0] + args[1];
+                case Instruction::SUBTRACT: return args[0] - args[1];
+                case Instruction::MULTIPLY: return args[0] * args[1];
+                case Instruction::DIVIDE:   return args[0] / args[1];
+
+                case Instruction::POWER:
+                case Instruction::POW:  return traits.powFunction(args[0], args[1]);
+                case Instruction::SQRT: return traits.sqrtFunction(args[0]);
+                case Instruction::SIN:  return traits.sinFunction(args[0]);
+                case Instruction::COS:  return traits.cosFunction(args[0]);
+                case Instruction::TAN:  return traits.tanFunction(args[0]);
+                case Instruction::COT:  // cot = 1 / tan, if there isn't cotangent function
+                    return traits.cotFunction ? traits.cotFunction(args[0]) : Real(1) / traits.tanFunction(args[0]);
+                case Instruction::LN:   return traits.lnFunction(args[0]);
+
+                case Instruction::SUM: return _Reduce(VectorKernels::Reduction::SUM, args, argCount);
+                case Instruction::AVG: return _Reduce(VectorKernels::Reduction::SUM, args, argCount) / Real(argCount);
+                case Instruction::MIN: return _Reduce(VectorKernels::Reduction::MIN, args, argCount);
+                case Instruction::MAX: return _Reduce(VectorKernels::Reduction::MAX, args, argCount);
+
+                case Instruction::STDDEV: { // deviations from the mean (second pass) don't lose precision to cancellation
+                    Real mean     = _Reduce(VectorKernels::Reduction::SUM, args, argCount) / Real(argCount);
+                    Real deviance = _Reduce(VectorKernels::Reduction::SUM_SQUARED_DEVIATIONS, args, argCount, mean);
+                    return traits.sqrtFunction(deviance / Real(argCount));
+                }
+
+                default: return Real(0);
+            }
+        }
+
+        static Real _Run(const _Program& program, const Real* variables) {
+            return _Run(
+                program.code.data(), program.code.size(), program.constants.data(), program.stackSize,
+                variables, program.traits
+            );
+        }
+
+        static Real _Run(
+            const Instruction* code,
+            size_t codeSize,
+            const Real* constants,
+            size_t stackSize,
+            const Real* variables,
+            const Traits& traits
+        ) {
+            Real localStack[s_LocalStackSize];
+
+            Real* stack = localStack;
+            if (stackSize > s_LocalStackSize) {
+                // keeps its blocks, so deep programs don't allocate after the first run on the thread
+                static thread_local Arena s_stackArena;
+                s_stackArena.Reset();
+                stack = s_stackArena.CreateArray<Real>(stackSize);
+            }
+
+            // index of the next free stack slot
+            size_t top = 0;
+
+            for (size_t i = 0; i < codeSize; ++i) {
+                const Instruction& instruction = code[i];
+
+                switch (instruction.opcode) {
+                    case Instruction::PUSH_CONSTANT: stack[top++] = constants[instruction.operand]; break;
+                    case Instruction::PUSH_VARIABLE: stack[top++] = variables[instruction.operand]; break;
+
+                    case Instruction::NEGATE: stack[top - 1] = -stack[top - 1]; break;
+
+                    case Instruction::ADD:      --top; stack[top - 1] = stack[top - 1] + stack[top]; break;
+                    case Instruction::SUBTRACT: --top; stack[top - 1] = stack[top - 1] - stack[top]; break;
+                    case Instruction::MULTIPLY: --top; stack[top - 1] = stack[top - 1] * stack[top]; break;
+                    case Instruction::DIVIDE:   --top; stack[top - 1] = stack[top - 1] / stack[top]; break;
+
+                    case Instruction::POWER:
+                    case Instruction::POW:
+                        --top;
+                        stack[top - 1] = traits.powFunction(stack[top - 1], stack[top]);
+                        break;
+
+                    case Instruction::AVG:
+                    case Instruction::SUM:
+                    case Instruction::MIN:
+                    case Instruction::MAX:
+                    case Instruction::STDDEV: // arguments are contiguous on the stack
+                        top -= instruction.operand;
+                        stack[top] = _Apply(instruction.opcode, stack + top, instruction.operand, traits);
+                        ++top;
+                        break;
+
+                    default: // functions with 1 argument
+                        stack[top - 1] = _Apply(instruction.opcode, stack + top - 1, 1, traits);
+                        break;
+                }
+            }
+            return stack[0];
+        }
+
+        // Every instruction writes its own value slot, arguments refer to the slots of earlier instructions
+        static void _RunSet(const _SetProgram& program, const Real* variables, Real* results) {
+            Real localValues[s_LocalStackSize];
+
+            Real* values = localValues;
+            if (program.code.size() > s_LocalStackSize) {
+                static thread_local Arena s_valueArena;
+                s_valueArena.Reset();
+                values = s_valueArena.CreateArray<Real>(program.code.size());
+            }
+
+            // arguments of aggregate are gathered to contiguous storage
+            Real localArgValues[s_LocalStackSize];
+
+            const Real*     constants = program.constants.data();
+            const uint32_t* args      = program.arguments.data();
+            const Traits&   traits    = program.traits;
+
+            for (size_t i = 0; i < program.code.size(); ++i) {
+                const Instruction& instruction = program.code[i];
+
+                switch (instruction.opcode) {
+                    case Instruction::PUSH_CONSTANT: values[i] = constants[instruction.operand]; break;
+                    case Instruction::PUSH_VARIABLE: values[i] = variables[instruction.operand]; break;
+
+                    case Instruction::NEGATE: values[i] = -values[args[0]]; args += 1; break;
+
+                    case Instruction::ADD:      values[i] = values[args[0]] + values[args[1]]; args += 2; break;
+                    case Instruction::SUBTRACT: values[i] = values[args[0]] - values[args[1]]; args += 2; break;
+                    case Instruction::MULTIPLY: values[i] = values[args[0]] * values[args[1]]; args += 2; break;
+                    case Instruction::DIVIDE:   values[i] = values[args[0]] / values[args[1]]; args += 2; break;
+
+                    case Instruction::POWER:
+                    case Instruction::POW:
+                        values[i] = traits.powFunction(values[args[0]], values[args[1]]);
+                        args += 2;
+                        break;
+
+                    case Instruction::AVG:
+                    case Instruction::SUM:
+                    case Instruction::MIN:
+                    case Instruction::MAX:
+                    case Instruction::STDDEV: {
+                        Real* argValues = localArgValues;
+                        if (instruction.operand > s_LocalStackSize) {
+                            static thread_local Arena s_argArena;
+                            s_argArena.Reset();
+                            argValues = s_argArena.CreateArray<Real>(instruction.operand);
+                        }
+
+                        for (size_t j = 0; j < instruction.operand; ++j) {
+                            argValues[j] = values[args[j]];
+                        }
+                        values[i] = _Apply(instruction.opcode, argValues, instruction.operand, traits);
+                        args += instruction.operand;
+                        break;
+                    }
+
+                    default: // functions with 1 argument
+                        values[i] = _Apply(instruction.opcode, values + args[0], 1, traits);
+                        args += 1;
+                        break;
+                }
+            }
+
+            for (size_t i = 0; i < program.outputs.size(); ++i) {
+                results[i] = values[program.outputs[i]];
+            }
+        }
+
+        // Forward sweep records value and argument instructions of each instruction (the tape),
+        // backward sweep propagates adjoints from the result to the arguments and variables
+        static Real _RunGradient(const _Program& program, const Real* variables, Real* gradient) {
+            static thread_local Arena s_tapeArena;
+            s_tapeArena.Reset();
+
+            size_t size = program.code.size();
+
+            Real*     values       = s_tapeArena.CreateArray<Real>(size);
+            Real*     adjoints     = s_tapeArena.CreateArray<Real>(size);
+            uint32_t* arguments    = s_tapeArena.CreateArray<uint32_t>(size);
+            uint32_t* argumentEnds = s_tapeArena.CreateArray<uint32_t>(size); // arguments of each instruction end here
+            uint32_t* stack        = s_tapeArena.CreateArray<uint32_t>(program.stackSize);
+            Real*     argValues    = s_tapeArena.CreateArray<Real>(program.stackSize);
+
+            const Traits& traits = program.traits;
+
+            size_t top           = 0;
+            size_t argumentCount = 0;
+
+            for (size_t i = 0; i < size; ++i) {
+                const Instruction& instruction = program.code[i];
+
+                switch (instruction.opcode) {
+                    case Instruction::PUSH_CONSTANT: values[i] = program.constants[instruction.operand]; break;
+                    case Instruction::PUSH_VARIABLE: values[i] = variables[instruction.operand]; break;
+
+                    default: {
+                        size_t argCount = instruction.GetArgCount();
+                        top -= argCount;
+
+                        for (size_t j = 0; j < argCount; ++j) {
+                            argValues[j] = values[stack[top + j]];
+                            arguments[argumentCount++] = stack[top + j];
+                        }
+                        values[i] = _Apply(instruction.opcode, argValues, argCount, traits);
+                        break;
+                    }
+                }
+
+                argumentEnds[i] = (uint32_t)argumentCount;
+                stack[top++] = (uint32_t)i;
+            }
+
+            std::fill(gradient, gradient + program.variableCount, Real(0));
+            adjoints[size - 1] = Real(1);
+
+            for (size_t i = size; i-- > 0;) {
+                const Instruction& instruction = program.code[i];
+                const Real&        adjoint     = adjoints[i];
+
+                // subexpression doesn't affect the result (and infinite derivatives don't make NaN of it)
+                if (adjoint == Real(0)) {
+                    continue;
+                }
+
+                const uint32_t* args = arguments + argumentEnds[i] - instruction.GetArgCount();
+
+                switch (instruction.opcode) {
+                    case Instruction::PUSH_CONSTANT: break;
+                    case Instruction::PUSH_VARIABLE:
+                        gradient[instruction.operand] = gradient[instruction.operand] + adjoint;
+                        break;
+
+                    case Instruction::NEGATE: adjoints[args[0]] = adjoints[args[0]] - adjoint; break;
+
+                    case Instruction::ADD:
+                        adjoints[args[0]] = adjoints[args[0]] + adjoint;
+                        adjoints[args[1]] = adjoints[args[1]] + adjoint;
+                        break;
+                    case Instruction::SUBTRACT:
+                        adjoints[args[0]] = adjoints[args[0]] + adjoint;
+                        adjoints[args[1]] = adjoints[args[1]] - adjoint;
+                        break;
+                    case Instruction::MULTIPLY:
+                        adjoints[args[0]] = adjoints[args[0]] + adjoint * values[args[1]];
+                        adjoints[args[1]] = adjoints[args[1]] + adjoint * values[args[0]];
+                        break;
+                    case Instruction::DIVIDE:
+                        adjoints[args[0]] = adjoints[args[0]] + adjoint / values[args[1]];
+                        adjoints[args[1]] = adjoints[args[1]] - adjoint * values[i] / values[args[1]];
+                        break;
+
+                    case Instruction::POWER:
+                    case Instruction::POW: {
+                        const Real& base     = values[args[0]];
+                        const Real& exponent = values[args[1]];
+
+                        if (!(exponent == Real(0))) {
+                            adjoints[args[0]] = adjoints[args[0]] +
+                                adjoint * exponent * traits.powFunction(base, exponent - Real(1));
+                        }
+                        // ln of negative base is NaN, it reaches only variables of non-constant exponent
+                        if (!(base == Real(0))) {
+                            adjoints[args[1]] = adjoints[args[1]] + adjoint * values[i] * traits.lnFunction(base);
+                        }
+                        break;
+                    }
+
+                    case Instruction::SQRT:
+                        adjoints[args[0]] = adjoints[args[0]] + adjoint / (Real(2) * values[i]);
+                        break;
+                    case Instruction::SIN:
+                        adjoints[args[0]] = adjoints[args[0]] + adjoint * traits.cosFunction(values[args[0]]);
+                        break;
+                    case Instruction::COS:
+                        adjoints[args[0]] = adjoints[args[0]] - adjoint * traits.sinFunction(values[args[0]]);
+                        break;
+                    case Instruction::TAN:
+                        adjoints[args[0]] = adjoints[args[0]] + adjoint * (Real(1) + values[i] * values[i]);
+                        break;
+                    case Instruction::COT:
+                        adjoints[args[0]] = adjoints[args[0]] - adjoint * (Real(1) + values[i] * values[i]);
+                        break;
+                    case Instruction::LN:
+                        adjoints[args[0]] = adjoints[args[0]] + adjoint / values[args[0]];
+                        break;
+
+                    case Instruction::SUM:
+                        for (size_t j = 0; j < instruction.operand; ++j) {
+                            adjoints[args[j]] = adjoints[args[j]] + adjoint;
+                        }
+                        break;
+                    case Instruction::AVG:
+                        for (size_t j = 0; j < instruction.operand; ++j) {
+                            adjoints[args[j]] = adjoints[args[j]] + adjoint / Real(instruction.operand);
+                        }
+                        break;
+
+                    case Instruction::MIN:
+                    case Instruction::MAX: // first argument, which is the result
+                        for (size_t j = 0; j < instruction.operand; ++j) {
+                            if (values[args[j]] == values[i]) {
+                                adjoints[args[j]] = adjoints[args[j]] + adjoint;
+                                break;
+                            }
+                        }
+                        break;
+
+                    case Instruction::STDDEV: {
+                        // derivative is infinite, where all arguments are equal
+                        if (values[i] == Real(0)) {
+                            break;
+                        }
+
+                        size_t argCount = instruction.operand;
+                        for (size_t j = 0; j < argCount; ++j) {
+                            argValues[j] = values[args[j]];
+                        }
+                        Real mean = _Reduce(VectorKernels::Reduction::SUM, argValues, argCount) / Real(argCount);
+
+                        for (size_t j = 0; j < argCount; ++j) {
+                            adjoints[args[j]] = adjoints[args[j]] +
+                                adjoint * (values[args[j]] - mean) / (Real(argCount) * values[i]);
+                        }
+                        break;
+                    }
+
+                    default: break;
+                }
+            }
+
+            return values[size - 1];
+        }
+
+    private:
+        static constexpr size_t s_BatchBlockSize = 256;
+
+        // Column-at-a-time evaluation: every instruction is applied to a block of rows
+        static void _RunBatch(const _Program& program, const Real* const* columns, size_t rowCount, Real* results) {
+            static thread_local Arena s_batchArena;
+            s_batchArena.Reset();
+
+            // block of rows for each stack slot
+            Real*        blocks = s_batchArena.CreateArray<Real>(program.stackSize * s_BatchBlockSize);
+            const Real** stack  = s_batchArena.CreateArray<const Real*>(program.stackSize);
+
+            const Real*   constants = program.constants.data();
+            const Traits& traits    = program.traits;
+
+            for (size_t row = 0; row < rowCount; row += s_BatchBlockSize) {
+                size_t n   = std::min(s_BatchBlockSize, rowCount - row);
+                size_t top = 0;
+
+                for (const Instruction& instruction : program.code) {
+                    switch (instruction.opcode) {
+                        case Instruction::PUSH_CONSTANT: {
+                            Real* out = blocks + top * s_BatchBlockSize;
+                            _BatchFill(out, constants[instruction.operand], n);
+                            stack[top++] = out;
+                            break;
+                        }
+                        case Instruction::PUSH_VARIABLE:
+                            stack[top++] = columns[instruction.operand] + row;
+                            break;
+
+                        default: {
+                            size_t argCount = instruction.GetArgCount();
+                            top -= argCount;
+
+                            Real* out = blocks + top * s_BatchBlockSize;
+                            _BatchApply(instruction.opcode, out, stack + top, argCount, n, traits);
+                            stack[top++] = out;
+                            break;
+                        }
+                    }
+                }
+
+                std::copy(stack[0], stack[0] + n, results + row);
+            }
+        }
+
+        // Vector kernels of Real (double and float only)
+        static constexpr bool s_HasBatchKernels = std::is_same_v<Real, double> || std::is_same_v<Real, float>;
+
+        struct _BatchKernels {
+        public:
+            void(*add)(Real*, const Real*, const Real*, size_t);
+            void(*subtract)(Real*, const Real*, const Real*, size_t);
+            void(*multiply)(Real*, const Real*, const Real*, size_t);
+            void(*divide)(Real*, const Real*, const Real*, size_t);
+            void(*negate)(Real*, const Real*, size_t);
+            void(*fill)(Real*, Real, size_t);
+        };
+
+        static _BatchKernels _GetBatchKernels() {
+            const VectorKernels& kernels = VectorKernels::Get();
+            if constexpr (std::is_same_v<Real, float>) {
+                return {
+                    kernels.addFloat, kernels.subtractFloat, kernels.multiplyFloat,
+                    kernels.divideFloat, kernels.negateFloat, kernels.fillFloat
+                };
+            }
+            else {
+                return { kernels.add, kernels.subtract, kernels.multiply, kernels.divide, kernels.negate, kernels.fill };
+            }
+        }
+
+        static void _BatchFill(Real* out, const Real& value, size_t n) {
+            if constexpr (s_HasBatchKernels) {
+                _GetBatchKernels().fill(out, value, n);
+            }
+            else {
+                std::fill(out, out + n, value);
+            }
+        }
+
+        // "out" may be one of the argument blocks
+        static void _BatchApply(
+            Instruction::OpCode opcode,
+            Real* out,
+            const Real* const* args,
+            size_t argCount,
+            size_t n,
+            const Traits& traits
+        ) {
+            if (opcode >= Instruction::AVG) {
+                _BatchAggregate(opcode, out, args, argCount, n, traits);
+                return;
+            }
+
+            if constexpr (s_HasBatchKernels) {
+                const _BatchKernels kernels = _GetBatchKernels();
+                switch (opcode) {
+                    case Instruction::NEGATE:   kernels.negate(out, args[0], n); return;
+                    case Instruction::ADD:      kernels.add(out, args[0], args[1], n); return;
+                    case Instruction::SUBTRACT: kernels.subtract(out, args[0], args[1], n); return;
+                    case Instruction::MULTIPLY: kernels.multiply(out, args[0], args[1], n); return;
+                    case Instruction::DIVIDE:   kernels.divide(out, args[0], args[1], n); return;
+
+                    default: break;
+                }
+            }
+
+            for (size_t i = 0; i < n; ++i) {
+                Real values[2] = { args[0][i], argCount > 1 ? args[1][i] : Real(0) };
+                out[i] = _Apply(opcode, values, argCount, traits);
+            }
+        }
+
+        // Aggregate of each row with the same order of operations as _Apply, "out" may be the first argument block
+        static void _BatchAggregate(
+            Instruction::OpCode opcode,
+            Real* out,
+            const Real* const* args,
+            size_t argCount,
+            size_t n,
+            const Traits& traits
+        ) {
+            using Reduction = VectorKernels::Reduction;
+
+            // block of each lane, block of each level of the pairwise split and block of the means
+            size_t levelCount = 0;
+            for (size_t count = argCount; count > VectorKernels::REDUCTION_BLOCK_SIZE; ++levelCount) {
+                count -= VectorKernels::SplitReduction(count); // right half is the larger one
+            }
+
+            static thread_local Arena s_reductionArena;
+            s_reductionArena.Reset();
+
+            Real* lanes  = s_reductionArena.CreateArray<Real>(VectorKernels::REDUCTION_LANE_COUNT * s_BatchBlockSize);
+            Real* levels = s_reductionArena.CreateArray<Real>(std::max<size_t>(levelCount, 1) * s_BatchBlockSize);
+            Real* means  = s_reductionArena.CreateArray<Real>(s_BatchBlockSize);
+
+            switch (opcode) {
+                case Instruction::SUM: _BatchReduce(Reduction::SUM, out, args, argCount, n, nullptr, lanes, levels); return;
+                case Instruction::MIN: _BatchReduce(Reduction::MIN, out, args, argCount, n, nullptr, lanes, levels); return;
+                case Instruction::MAX: _BatchReduce(Reduction::MAX, out, args, argCount, n, nullptr, lanes, levels); return;
+
+                case Instruction::AVG:
+                    _BatchReduce(Reduction::SUM, out, args, argCount, n, nullptr, lanes, levels);
+                    for (size_t i = 0; i < n; ++i) {
+                        out[i] = out[i] / Real(argCount);
+                    }
+                    return;
+
+                default: // STDDEV
+                    _BatchReduce(Reduction::SUM, means, args, argCount, n, nullptr, lanes, levels);
+                    for (size_t i = 0; i < n; ++i) {
+                        means[i] = means[i] / Real(argCount);
+                    }
+
+                    _BatchReduce(Reduction::SUM_SQUARED_DEVIATIONS, out, args, argCount, n, means, lanes, levels);
+                    for (size_t i = 0; i < n; ++i) {
+                        out[i] = traits.sqrtFunction(out[i] / Real(argCount));
+                    }
+                    return;
+            }
+        }
+
+        // VectorKernels::ReduceScalar of each row, "out" is written after the first argument block is read
+        static void _BatchReduce(
+            VectorKernels::Reduction reduction,
+            Real* out,
+            const Real* const* args,
+            size_t argCount,
+            size_t n,
+            const Real* means,
+            Real* lanes,
+            Real* levels
+        ) {
+            using Reduction = VectorKernels::Reduction;
+            constexpr size_t laneCount = VectorKernels::REDUCTION_LANE_COUNT;
+
+            if (argCount > VectorKernels::REDUCTION_BLOCK_SIZE) {
+                size_t half  = VectorKernels::SplitReduction(argCount);
+                Real*  right = levels;
+
+                _BatchReduce(reduction, out, args, half, n, means, lanes, levels + s_BatchBlockSize);
+                _BatchReduce(reduction, right, args + half, argCount - half, n, means, lanes, levels + s_BatchBlockSize);
+                for (size_t i = 0; i < n; ++i) {
+                    out[i] = VectorKernels::Combine(reduction, out[i], right[i]);
+                }
+                return;
+            }
+
+            std::fill(lanes, lanes + laneCount * s_BatchBlockSize, VectorKernels::GetIdentity<Real>(reduction));
+
+            for (size_t k = 0; k < argCount; ++k) {
+                Real*       lane = lanes + (k % laneCount) * s_BatchBlockSize;
+                const Real* arg  = args[k];
+
+                switch (reduction) {
+                    case Reduction::SUM:
+                        for (size_t i = 0; i < n; ++i) {
+                            lane[i] = lane[i] + arg[i];
+                        }
+                        break;
+                    case Reduction::SUM_SQUARED_DEVIATIONS:
+                        for (size_t i = 0; i < n; ++i) {
+                            Real deviation = arg[i] - means[i];
+                            lane[i] = lane[i] + deviation * deviation;
+                        }
+                        break;
+                    default:
+                        for (size_t i = 0; i < n; ++i) {
+                            lane[i] = VectorKernels::Combine(reduction, lane[i], arg[i]);
+                        }
+                        break;
+                }
+            }
+
+            for (size_t i = 0; i < n; ++i) {
+                Real values[laneCount];
+                for (size_t j = 0; j < laneCount; ++j) {
+                    values[j] = lanes[j * s_BatchBlockSize + i];
+                }
+                out[i] = VectorKernels::CombineLanes(reduction, values);
+            }
+        }
+
+    private:
+        // Nodes are allocated in the arena of the program, so they only refer to each other
+        struct _ExprNode {
+        public:
+            const _ExprNode* const* args     = nullptr;
+            size_t                  argCount = 0;
+            Instruction::OpCode     opcode   = Instruction::PUSH_CONSTANT;
+
+            Real   value = Real(0); // of PUSH_CONSTANT
+            size_t slot  = 0;       // of PUSH_VARIABLE
+        };
+
+        struct _Program {
+        public:
+            _Program(const Traits& traits) : traits(traits) {}
+
+        public:
+            std::vector<Instruction> code;
+            std::vector<Real>        constants;
+
+            size_t stackSize     = 0;
+            size_t variableCount = 0;
+            Traits traits;
+
+            // Whole expression is integer, its exact value
+            bool    isInteger    = false;
+            Integer integerValue = 0;
+
+            // Debug form of the program (KEEP_TREE)
+            Arena            treeArena;
+            const _ExprNode* tree      = nullptr;
+            size_t           treeDepth = 0;
+
+            // Native form of the program (ENABLE_JIT)
+            JitFunction jit;
+        };
+
+        static void _CompileNative(_Program& program) {
+            if constexpr (std::is_same_v<Real, double>) {
+                if (!JitFunction::IsSupported()) {
+                    return;
+                }
+
+                JitFunction::Calls calls;
+                calls.sqrtFunction = program.traits.sqrtFunction;
+                calls.powFunction  = program.traits.powFunction;
+                calls.sinFunction  = program.traits.sinFunction;
+                calls.cosFunction  = program.traits.cosFunction;
+                calls.tanFunction  = program.traits.tanFunction;
+                calls.cotFunction  = program.traits.cotFunction;
+                calls.lnFunction   = program.traits.lnFunction;
+
+                program.jit = JitFunction::Compile(
+                    program.code.data(), program.code.size(), program.constants.data(), program.stackSize, calls
+                );
+            }
+        }
+
+        // Fold constant subexpressions and apply identities, which don't change result for any input
+        static void _Optimize(_Program& program, uint64_t flags) {
+            struct Operand {
+            public:
+                size_t begin;      // first instruction of the operand in the new code
+                bool   isConstant;
+                Real   value;
+            };
+
+            std::vector<Instruction> code;
+            std::vector<Real>        constants;
+            std::vector<Operand>     stack;
+
+            code.reserve(program.code.size());
+            stack.reserve(program.stackSize);
+
+            auto pushConstant = [&](const Real& value) {
+                stack.push_back(Operand{ code.size(), true, value });
+
+                Instruction instruction;
+                instruction.opcode  = Instruction::PUSH_CONSTANT;
+                instruction.operand = (uint32_t)constants.size();
+                code.emplace_back(instruction);
+                constants.emplace_back(value);
+            };
+
+            auto isConstant = [](const Operand& operand, const Real& value, bool isNegativeZero = false) {
+                return operand.isConstant && operand.value == value &&
+                    (value != Real(0) || _IsNegativeZero(operand.value) == isNegativeZero);
+            };
+
+            // Last instruction of the operand is negation
+            auto isNegated = [&](const Operand& operand) {
+                return !operand.isConstant && code.back().opcode == Instruction::NEGATE;
+            };
+
+            bool ignoreSignedZeros = flags & IGNORE_SIGNED_ZEROS;
+
+            for (const Instruction& instruction : program.code) {
+                if (instruction.opcode == Instruction::PUSH_CONSTANT) {
+                    pushConstant(program.constants[instruction.operand]);
+                    continue;
+                }
+                if (instruction.opcode == Instruction::PUSH_VARIABLE) {
+                    stack.push_back(Operand{ code.size(), false, Real(0) });
+                    code.emplace_back(instruction);
+                    continue;
+                }
+
+                size_t   argCount = instruction.GetArgCount();
+                Operand* args     = stack.data() + stack.size() - argCount;
+
+                bool allConstant = true;
+                for (size_t i = 0; i < argCount; ++i) {
+                    allConstant = allConstant && args[i].isConstant;
+                }
+
+                if (allConstant) {
+                    std::vector<Real> values(argCount);
+                    for (size_t i = 0; i < argCount; ++i) {
+                        values[i] = args[i].value;
+                    }
+                    Real result = _Apply(instruction.opcode, values.data(), argCount, program.traits);
+
+                    code.resize(args[0].begin);
+                    stack.resize(stack.size() - argCount);
+                    pushConstant(result);
+                    continue;
+                }
+
+                Instruction::OpCode opcode = instruction.opcode;
+
+                if (opcode == Instruction::NEGATE) {
+                    if (isNegated(args[0])) { // -(-x) = x
+                        code.pop_back();
+                    }
+                    else {
+                        code.emplace_back(instruction);
+                    }
+                    continue;
+                }
+
+                if (argCount != 2 || opcode > Instruction::DIVIDE) {
+                    size_t begin = args[0].begin;
+                    stack.resize(stack.size() - argCount);
+                    stack.push_back(Operand{ begin, false, Real(0) });
+                    code.emplace_back(instruction);
+                    continue;
+                }
+
+                Operand& left  = args[0];
+                Operand& right = args[1];
+
+                // x * 1, x / 1, x - 0, x + (-0) (and x + 0, if sign of zero is ignored)
+                bool dropRight =
+                    ((opcode == Instruction::MULTIPLY || opcode == Instruction::DIVIDE) && isConstant(right, Real(1))) ||
+                    (opcode == Instruction::SUBTRACT && (isConstant(right, Real(0)) ||
+                        (ignoreSignedZeros && isConstant(right, Real(0), true)))) ||
+                    (opcode == Instruction::ADD && (isConstant(right, Real(0), true) ||
+                        (ignoreSignedZeros && isConstant(right, Real(0)))));
+
+                // 1 * x, (-0) + x (and 0 + x, if sign of zero is ignored)
+                bool dropLeft =
+                    (opcode == Instruction::MULTIPLY && isConstant(left, Real(1))) ||
+                    (opcode == Instruction::ADD && (isConstant(left, Real(0), true) ||
+                        (ignoreSignedZeros && isConstant(left, Real(0)))));
+
+                if (dropRight) {
+                    code.resize(right.begin);
+                    stack.pop_back();
+                    continue;
+                }
+                if (dropLeft) {
+                    code.erase(code.begin() + left.begin);
+                    stack.pop_back();
+                    stack.back() = Operand{ left.begin, false, Real(0) };
+                    continue;
+                }
+
+                // x + (-y) = x - y, x - (-y) = x + y
+                if ((opcode == Instruction::ADD || opcode == Instruction::SUBTRACT) && isNegated(right)) {
+                    code.pop_back();
+                    opcode = opcode == Instruction::ADD ? Instruction::SUBTRACT : Instruction::ADD;
+                }
+
+                stack.pop_back();
+                stack.back() = Operand{ left.begin, false, Real(0) };
+
+                Instruction optimized = instruction;
+                optimized.opcode = opcode;
+                code.emplace_back(optimized);
+            }
+
+            program.code      = std::move(code);
+            program.constants = std::move(constants);
+            program.stackSize = _GetStackSize(program.code);
+            _RemoveDeadConstants(program);
+        }
+
+        // Typing pass: integer literals are Integer, +, -, * and ^ (with non-negative exponent), sum, min and max
+        // of Integers are Integer, anything else is Real. Variables are Real, so integer subexpressions are constant:
+        // they are evaluated here exactly and promoted to Real, where real operation uses them or their value overflows Integer
+        static void _FoldIntegers(_Program& program, const std::vector<std::pair<bool, Integer>>& integerConstants) {
+            struct Operand {
+            public:
+                size_t  begin;     // first instruction of the operand in the new code
+                bool    isInteger;
+                Integer value;
+            };
+
+            std::vector<Instruction> code;
+            std::vector<Real>        constants;
+            std::vector<Operand>     stack;
+
+            code.reserve(program.code.size());
+            constants.reserve(program.constants.size());
+            stack.reserve(program.stackSize);
+
+            auto pushConstant = [&](const Real& value, bool isInteger, const Integer& integer) {
+                stack.push_back(Operand{ code.size(), isInteger, integer });
+
+                Instruction instruction;
+                instruction.opcode  = Instruction::PUSH_CONSTANT;
+                instruction.operand = (uint32_t)constants.size();
+                code.emplace_back(instruction);
+                constants.emplace_back(value);
+            };
+
+            for (const Instruction& instruction : program.code) {
+                if (instruction.opcode == Instruction::PUSH_CONSTANT) {
+                    const std::pair<bool, Integer>& integer = integerConstants[instruction.operand];
+                    pushConstant(program.constants[instruction.operand], integer.first, integer.second);
+                    continue;
+                }
+                if (instruction.opcode == Instruction::PUSH_VARIABLE) {
+                    stack.push_back(Operand{ code.size(), false, Integer(0) });
+                    code.emplace_back(instruction);
+                    continue;
+                }
+
+                size_t   argCount = instruction.GetArgCount();
+                Operand* args     = stack.data() + stack.size() - argCount;
+                size_t   begin    = args[0].begin;
+
+                bool allInteger = true;
+                for (size_t i = 0; i < argCount; ++i) {
+                    allInteger = allInteger && args[i].isInteger;
+                }
+
+                auto getValue = [args](size_t i) { return args[i].value; };
+
+                Integer result = 0;
+                if (allInteger && (_ApplyInteger(instruction.opcode, args[0].value, args[argCount - 1].value, result) ||
+                    _AggregateInteger(instruction.opcode, argCount, getValue, result))) {
+                    code.resize(begin);
+                    stack.resize(stack.size() - argCount);
+                    pushConstant(static_cast<Real>(result), true, result);
+                    continue;
+                }
+
+                stack.resize(stack.size() - argCount);
+                stack.push_back(Operand{ begin, false, Integer(0) });
+                code.emplace_back(instruction);
+            }
+
+            program.isInteger    = stack.back().isInteger;
+            program.integerValue = stack.back().value;
+
+            program.code      = std::move(code);
+            program.constants = std::move(constants);
+            program.stackSize = _GetStackSize(program.code);
+            _RemoveDeadConstants(program);
+        }
+
+        static size_t _GetStackSize(const std::vector<Instruction>& code) {
+            size_t depth    = 0;
+            size_t maxDepth = 0;
+            for (const Instruction& instruction : code) {
+                depth = depth + 1 - instruction.GetArgCount();
+                maxDepth = std::max(maxDepth, depth);
+            }
+            return maxDepth;
+        }
+
+        // Folded and dropped operands leave their constants in the pool, only pushed ones are kept (in order of the code)
+        static void _RemoveDeadConstants(_Program& program) {
+            std::vector<Real> constants;
+            for (Instruction& instruction : program.code) {
+                if (instruction.opcode == Instruction::PUSH_CONSTANT) {
+                    constants.emplace_back(program.constants[instruction.operand]);
+                    instruction.operand = (uint32_t)(constants.size() - 1);
+                }
+            }
+            program.constants = std::move(constants);
+        }
+
+        static bool _IsNegativeZero(const Real& value) {
+            return value == Real(0) && Real(1) / value < Real(0);
+        }
+
+        // Rebuild expression tree from the postfix program
+        static const _ExprNode* _BuildTree(_Program& program) {
+            Arena& arena = program.treeArena;
+
+            // node and its depth
+            std::vector<std::pair<const _ExprNode*, size_t>> stack;
+            stack.reserve(program.stackSize);
+
+            for (const Instruction& instruction : program.code) {
+                _ExprNode* node = arena.Create<_ExprNode>();
+                node->opcode = instruction.opcode;
+
+                if (instruction.opcode == Instruction::PUSH_CONSTANT) {
+                    node->value = program.constants[instruction.operand];
+                    stack.emplace_back(node, 1);
+                    continue;
+                }
+                if (instruction.opcode == Instruction::PUSH_VARIABLE) {
+                    node->slot = instruction.operand;
+                    stack.emplace_back(node, 1);
+                    continue;
+                }
+
+                size_t argCount = instruction.GetArgCount();
+                const _ExprNode** args = arena.CreateArray<const _ExprNode*>(argCount);
+
+                size_t depth = 0;
+                for (size_t i = 0; i < argCount; ++i) {
+                    const auto& [arg, argDepth] = stack[stack.size() - argCount + i];
+                    args[i] = arg;
+                    depth   = std::max(depth, argDepth);
+                }
+                stack.resize(stack.size() - argCount);
+
+                node->args     = args;
+                node->argCount = argCount;
+                stack.emplace_back(node, depth + 1);
+            }
+
+            program.treeDepth = stack.back().second;
+            return stack.back().first;
+        }
+
+        // Post-order walk with explicit stacks, which visits nodes in order of the postfix program,
+        // so values take at most "stackSize" slots
+        static Real _EvaluateTree(const _Program& program, const Real* variables) {
+            struct Frame {
+            public:
+                const _ExprNode* node;
+                size_t           next; // argument to evaluate
+            };
+
+            Frame localFrames[s_LocalStackSize];
+            Real  localValues[s_LocalStackSize];
+
+            Frame* frames = localFrames;
+            Real*  values = localValues;
+            if (program.treeDepth > s_LocalStackSize || program.stackSize > s_LocalStackSize) {
+                static thread_local Arena s_treeArena;
+                s_treeArena.Reset();
+                frames = s_treeArena.CreateArray<Frame>(program.treeDepth);
+                values = s_treeArena.CreateArray<Real>(program.stackSize);
+            }
+
+            // leaves are evaluated in place of their frames
+            auto evaluateLeaf = [variables](const _ExprNode* node) {
+                return node->opcode == Instruction::PUSH_CONSTANT ? node->value : variables[node->slot];
+            };
+
+            if (program.tree->argCount == 0) {
+                return evaluateLeaf(program.tree);
+            }
+
+            size_t depth = 0;
+            size_t top   = 0;
+            frames[depth++] = Frame{ program.tree, 0 };
+
+            while (depth > 0) {
+                Frame& frame = frames[depth - 1];
+                const _ExprNode* node = frame.node;
+
+                if (frame.next < node->argCount) {
+                    const _ExprNode* arg = node->args[frame.next++];
+                    if (arg->argCount == 0) {
+                        values[top++] = evaluateLeaf(arg);
+                    }
+                    else {
+                        frames[depth++] = Frame{ arg, 0 };
+                    }
+                    continue;
+                }
+
+                --depth;
+                top -= node->argCount;
+                values[top] = _Apply(node->opcode, values + top, node->argCount, program.traits);
+                ++top;
             }
 
-            // Left denotation
-            std::unique_ptr<_ExprNode> _Led(const Token* token, std::unique_ptr<_ExprNode>&& left) {
-                if (token->HasType(Token::BINARY)) {
-                    std::unique_ptr<_ExprNode> expr = Build(token->GetBP());
-                    return std::make_unique<_BinaryNode>(
-                        m_binaryFunctionMap[token->GetID()],
-                        std::move(left),
-                        std::move(expr)
-                    );
+            return values[0];
+        }
+
+    private:
+        struct _SetProgram {
+        public:
+            _SetProgram(const Traits& traits) : traits(traits) {}
+
+        public:
+            // Instructions in order of evaluation, each one is a distinct subexpression
+            std::vector<Instruction> code;
+            std::vector<uint32_t>    arguments; // instruction indices of the arguments, in order of the code
+            std::vector<uint32_t>    outputs;   // instruction index of each expression
+            std::vector<Real>        constants;
+
+            size_t variableCount = 0;
+            Traits traits;
+        };
+
+        // Hash-consing of the postfix programs: instruction with the same opcode, operand and argument instructions
+        // is emitted once (arguments of commutative operations are ordered, constants are matched by value and sign)
+        static std::shared_ptr<_SetProgram> _Merge(const CompiledExpression* expressions, size_t count) {
+            std::shared_ptr<_SetProgram> set = std::make_shared<_SetProgram>(
+                count > 0 ? expressions[0].m_program->traits : Traits()
+            );
+
+            std::map<std::pair<Real, bool>, uint32_t> constantIndices;
+            std::unordered_map<std::string, uint32_t> instructionIndices;
+
+            std::vector<uint32_t> stack;
+            std::string           key;
+
+            for (size_t e = 0; e < count; ++e) {
+                const _Program& program = *expressions[e].m_program;
+                set->variableCount = std::max(set->variableCount, program.variableCount);
+
+                stack.clear();
+                for (const Instruction& instruction : program.code) {
+                    size_t    argCount = instruction.GetArgCount();
+                    uint32_t* args     = stack.data() + stack.size() - argCount;
+
+                    Instruction merged = instruction;
+                    if (instruction.opcode == Instruction::PUSH_CONSTANT) {
+                        const Real& value = program.constants[instruction.operand];
+
+                        // NaN isn't equal to itself, so it isn't shared
+                        uint32_t constantIndex = (uint32_t)set->constants.size();
+                        if (value == value) {
+                            auto inserted = constantIndices.emplace(std::make_pair(value, _IsNegativeZero(value)), constantIndex);
+                            constantIndex = inserted.first->second;
+                        }
+                        if (constantIndex == set->constants.size()) {
+                            set->constants.emplace_back(value);
+                        }
+                        merged.operand = constantIndex;
+                    }
+                    else if (instruction.opcode == Instruction::ADD || instruction.opcode == Instruction::MULTIPLY) {
+                        if (args[0] > args[1]) {
+                            std::swap(args[0], args[1]);
+                        }
+                    }
+
+                    key.assign(reinterpret_cast<const char*>(&merged.opcode), sizeof(merged.opcode));
+                    key.append(reinterpret_cast<const char*>(&merged.operand), sizeof(merged.operand));
+                    key.append(reinterpret_cast<const char*>(args), argCount * sizeof(uint32_t));
+
+                    auto inserted = instructionIndices.emplace(key, (uint32_t)set->code.size());
+                    if (inserted.second) {
+                        set->code.emplace_back(merged);
+                        set->arguments.insert(set->arguments.end(), args, args + argCount);
+                    }
+
+                    stack.resize(stack.size() - argCount);
+                    stack.push_back(inserted.first->second);
+                }
+
+                set->outputs.push_back(stack.back());
+            }
+
+            return set;
+        }
+
+    private:
+        // LRU map from normalized expression text to compile result
+        class _Cache {
+        public:
+            bool Find(std::string_view key, Result<CompiledExpression, ErrorInfo>& result) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                auto it = m_map.find(key);
+                if (it == m_map.end()) {
+                    ++m_statistics.misses;
+                    return false;
+                }
+
+                ++m_statistics.hits;
+                m_entries.splice(m_entries.begin(), m_entries, it->second);
+                result = it->second->result;
+                return true;
+            }
+
+            void Insert(std::string_view key, const Result<CompiledExpression, ErrorInfo>& result) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                // entry could be added by other thread
+                if (m_map.find(key) != m_map.end()) {
+                    return;
+                }
+
+                size_t bytes = sizeof(_Entry) + sizeof(typename _Map::value_type) + (key.size() + 1) * 2 +
+                    (result.HasValue() ? result.Get().GetMemoryUsage() : 0);
+                if (bytes > m_byteBudget) {
+                    return;
                 }
 
-                // Disable warning
-                return std::unique_ptr<_ExprNode>();
+                m_entries.push_front(_Entry{ std::string(key), result, bytes });
+                m_map.emplace(m_entries.front().key, m_entries.begin());
+
+                ++m_statistics.entryCount;
+                m_statistics.byteCount += bytes;
+                _Evict();
+            }
+
+            void Clear() noexcept {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_map.clear();
+                m_entries.clear();
+                m_statistics.entryCount = m_statistics.byteCount = 0;
+            }
+
+            void SetByteBudget(size_t byteBudget) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_byteBudget = byteBudget;
+                _Evict();
+            }
+
+            CacheStatistics GetStatistics() const noexcept {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                return m_statistics;
+            }
+
+            void ResetStatistics() noexcept {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_statistics.hits = m_statistics.misses = m_statistics.evictions = 0;
+            }
+
+        private:
+            struct _Entry {
+            public:
+                std::string                                 key;
+                Result<CompiledExpression, ErrorInfo> result;
+                size_t                                      bytes;
             };
 
+            using _Map = std::unordered_map<std::string_view, typename std::list<_Entry>::iterator>;
+
         private:
-            void _InitFunctions() {
-                m_binaryFunctionMap = {
-                    { Token::PLUS,     [](const Real& x, const Real& y) { return x + y; } },
-                    { Token::MINUS,    [](const Real& x, const Real& y) { return x - y; } },
-                    { Token::ASTERISK, [](const Real& x, const Real& y) { return x * y; } },
-                    { Token::SLASH,    [](const Real& x, const Real& y) { return x / y; } },
-
-                    { Token::CARET, [this](const Real& x, const Real& y) {
-                        return m_traits->powFunction(x, y);
-                    }}
-                };
+            void _Evict() {
+                while (m_statistics.byteCount > m_byteBudget) {
+                    const _Entry& last = m_entries.back();
+                    m_statistics.byteCount -= last.bytes;
+                    --m_statistics.entryCount;
+                    ++m_statistics.evictions;
+
+                    m_map.erase(last.key);
+                    m_entries.pop_back();
+                }
+            }
+
+        private:
+            std::list<_Entry> m_entries; // most recently used first
+            _Map              m_map;
+
+            size_t          m_byteBudget = 0;
+            CacheStatistics m_statistics;
+
+            mutable std::mutex m_mutex;
+        };
+
+    private:
+        // Pratt parser with explicit stack of pending subexpressions, so nesting is limited by "depthLimit" only
+        class _Builder {
+        public:
+            _Builder() = default;
+
+            _Builder(const TokenStream* tokens, _Program* program, size_t depthLimit) :
+                m_tokens(tokens), m_program(program), m_depthLimit(depthLimit) {}
+
+        public:
+            // Emit postfix code of the whole expression
+            void Build() {
+                static thread_local std::vector<_Frame> s_frames;
+                s_frames.clear();
+
+                // whole expression isn't nested
+                std::vector<_Frame>& frames = s_frames;
+                frames.push_back(_Frame{ _Frame::SUBEXPRESSION, 0, Token(), 0, 0, 0 });
+
+                bool isOperandDone = false; // otherwise the next token begins an operand
+                while (!_HasFailed() && !frames.empty()) {
+                    if (!isOperandDone) {
+                        isOperandDone = _Nud(frames, _Advance());
+                        continue;
+                    }
+
+                    _Frame& frame = frames.back();
+                    switch (frame.kind) {
+                        case _Frame::SUBEXPRESSION: {
+                            Token token = _Get();
+                            if (token.info == 0 || token.HasType(Token::EOEX_LIKE) || frame.rbp >= token.GetBP()) {
+                                frames.pop_back();
+                                m_nesting -= m_nesting > 0;
+                                break;
+                            }
+
+                            // Left denotation
+                            _Advance();
+                            if (token.HasType(Token::BINARY)) {
+                                frames.push_back(_Frame{ _Frame::BINARY, 0, token, 0, 0, 0 });
+                                _BeginSubexpression(frames, token.GetBP());
+                                isOperandDone = false;
+                            }
+                            break;
+                        }
 
-                m_functionMap = {
-                    [this](const std::vector<std::unique_ptr<_ExprNode>>& args) {
-                        return m_traits->sqrtFunction(args[0]->Evaluate());
-                    },
-                    [this](const std::vector<std::unique_ptr<_ExprNode>>& args) {
-                        return m_traits->powFunction(args[0]->Evaluate(), args[1]->Evaluate());
-                    },
-                    [this](const std::vector<std::unique_ptr<_ExprNode>>& args) {
-                        return m_traits->sinFunction(args[0]->Evaluate());
-                    },
-                    [this](const std::vector<std::unique_ptr<_ExprNode>>& args) {
-                        return m_traits->cosFunction(args[0]->Evaluate());
-                    },
-                    [this](const std::vector<std::unique_ptr<_ExprNode>>& args) {
-                        return m_traits->tanFunction(args[0]->Evaluate());
-                    },
-                    m_traits->cotFunction ? // has cotangent function
-                        std::function<Real(const std::vector<std::unique_ptr<_ExprNode>>&)>(
-                        [this](const std::vector<std::unique_ptr<_ExprNode>>& args) {
-                            return m_traits->cotFunction(args[0]->Evaluate());
-                        }) : // otherwise use cot = 1 / tan
-                        std::function<Real(const std::vector<std::unique_ptr<_ExprNode>>&)>(
-                        [this](const std::vector<std::unique_ptr<_ExprNode>>& args) {
-                            return Real(1) / m_traits->tanFunction(args[0]->Evaluate());
-                        }),
-                    [this](const std::vector<std::unique_ptr<_ExprNode>>& args) {
-                        return m_traits->lnFunction(args[0]->Evaluate());
-                    },
-
-                    [](const std::vector<std::unique_ptr<_ExprNode>>& args) { // avg
-                        Real accumulation = 0;
-                        for (const std::unique_ptr<_ExprNode>& ptr : args) {
-                            accumulation += ptr->Evaluate();
+                        case _Frame::PAREN: {
+                            // parentheses are balanced (checked by validation), comma isn't allowed outside of function call
+                            Token token = _Advance();
+                            if (token.info == 0) {
+                                _Fail(ExpressionError::INVALID_PARENTHESES, m_tokens->GetSize() - 1);
+                            }
+                            else if (!token.Is(Token::CLOSE_PAREN)) {
+                                _Fail(ExpressionError::INVALID_COMMA_PLACE, m_index - 1);
+                            }
+                            frames.pop_back();
+                            break;
                         }
-                        return accumulation / Real(args.size());
+
+                        case _Frame::UNARY:
+                            if (frame.token.Is(Token::MINUS)) { // unary plus doesn't change the value
+                                _Emit(Instruction::NEGATE);
+                            }
+                            frames.pop_back();
+                            break;
+
+                        case _Frame::BINARY:
+                            _Emit((Instruction::OpCode)(Instruction::ADD + (frame.token.GetID() - Token::PLUS)));
+                            frames.pop_back();
+                            break;
+
+                        case _Frame::FUNCTION:
+                            ++frame.args;
+                            if (_Advance().Is(Token::COMMA)) {
+                                _BeginSubexpression(frames, 0);
+                                isOperandDone = false;
+                                break;
+                            }
+                            _EndFunction(frame);
+                            frames.pop_back();
+                            break;
                     }
+                }
+            }
+
+            // Whole expression must be consumed, up to EOEX (but not past it)
+            void Finish() {
+                if (_HasFailed()) {
+                    return;
+                }
+                if (m_index >= m_tokens->GetSize()) {
+                    _Fail(ExpressionError::INVALID_OPERATOR_PLACE, m_tokens->GetSize() - 1);
+                }
+                else if (!_Get().Is(Token::EOEX)) {
+                    _Fail(ExpressionError::INVALID_COMMA_PLACE, m_index);
+                }
+            }
+
+            // First error and index of the token, which caused it
+            ExpressionError GetError() const noexcept { return m_error; }
+            size_t GetErrorToken() const noexcept { return m_errorToken; }
+
+        private:
+            // Continuation of the operand, which is being parsed
+            struct _Frame {
+            public:
+                enum Kind : uint8_t {
+                    SUBEXPRESSION, // operators with binding power over "rbp" are taken into it
+                    PAREN,
+                    UNARY,
+                    BINARY,
+                    FUNCTION
                 };
+
+            public:
+                Kind    kind = SUBEXPRESSION;
+                uint8_t rbp  = 0;
+                Token   token;
+
+                size_t tokenIndex = 0; // of function
+                size_t argCount   = 0; // function takes
+                size_t args       = 0; // parsed
+            };
+
+        private:
+            // Tokens are unpacked from the stream by value, past the end the empty token (info == 0) stands for nullptr.
+            // It has no type, so Is() and HasType() are false for it: _Nud, the operator loop and the close paren check
+            // it explicitly, the argument list ends on it and Finish fails
+            Token _Advance() {
+                return m_index < m_tokens->GetSize() ? (*m_tokens)[m_index++] : Token();
+            }
+
+            Token _Get() const {
+                return m_index < m_tokens->GetSize() ? (*m_tokens)[m_index] : Token();
+            }
+
+            bool _HasFailed() const noexcept { return m_error != ExpressionError::IS_VALID; }
+
+            void _Fail(ExpressionError error, size_t tokenIndex) noexcept {
+                m_error      = error;
+                m_errorToken = tokenIndex;
+            }
+
+            void _BeginSubexpression(std::vector<_Frame>& frames, uint8_t rbp) {
+                if (++m_nesting > m_depthLimit) {
+                    _Fail(ExpressionError::TOO_DEEP, m_index - 1); // token, which opens the subexpression
+                    return;
+                }
+                frames.push_back(_Frame{ _Frame::SUBEXPRESSION, rbp, Token(), 0, 0, 0 });
+            }
+
+            // Null denotation (begin of the operand), returns true, if the operand is done.
+            // Payloads are taken in token order
+            bool _Nud(std::vector<_Frame>& frames, const Token& token) {
+                if (token.info == 0) {
+                    _Fail(ExpressionError::INVALID_OPERATOR_PLACE, m_index);
+                    return false;
+                }
+
+                if (token.HasType(Token::VARIABLE)) {
+                    size_t slot = m_tokens->m_indices.data[m_indexPayload++];
+                    m_program->variableCount = std::max(m_program->variableCount, slot + 1);
+                    _Emit(Instruction::PUSH_VARIABLE, slot);
+                    return true;
+                }
+                if (token.HasType(Token::NUMBER)) {
+                    if (token.HasType(Token::INTEGER)) {
+                        _EmitInteger(m_tokens->m_integers.data[m_integerPayload++]);
+                    }
+                    else {
+                        _EmitConstant(m_tokens->m_reals.data[m_realPayload++]);
+                    }
+                    return true;
+                }
+                if (token.Is(Token::OPEN_PAREN)) {
+                    frames.push_back(_Frame{ _Frame::PAREN, 0, token, 0, 0, 0 });
+                    _BeginSubexpression(frames, 0);
+                    return false;
+                }
+                if (token.HasType(Token::UNARY)) {
+                    frames.push_back(_Frame{ _Frame::UNARY, 0, token, 0, 0, 0 });
+                    _BeginSubexpression(frames, token.GetBP());
+                    return false;
+                }
+                if (token.HasType(Token::FUNCTION)) {
+                    _Frame frame{ _Frame::FUNCTION, 0, token, m_index - 1, m_tokens->m_indices.data[m_indexPayload++], 0 };
+
+                    // otherwise the argument list would end at EOEX and consume it
+                    if (!_Get().Is(Token::OPEN_PAREN)) {
+                        _Fail(ExpressionError::FUNCTION_WITHOUT_PARENTHESES, m_index);
+                        return false;
+                    }
+                    _Advance(); // skip open paren right after function
+
+                    if (_Get().Is(Token::CLOSE_PAREN)) {
+                        _Advance();
+                        _EndFunction(frame);
+                        return true;
+                    }
+
+                    frames.push_back(frame);
+                    _BeginSubexpression(frames, 0);
+                    return false;
+                }
+
+                // Missing operand (e.g. operator right before the end of expression)
+                _Fail(ExpressionError::INVALID_OPERATOR_PLACE, m_index - 1);
+                return false;
             }
 
-            const std::function<Real(const std::vector<std::unique_ptr<_ExprNode>>&)> _GetFunction(Token::ID id) const {
-                return m_functionMap[id - Token::SQRT];
+            void _EndFunction(const _Frame& frame) {
+                if (frame.argCount != frame.args || frame.args == 0) {
+                    _Fail(ExpressionError::INVALID_ARGUMENT_COUNT, frame.tokenIndex);
+                    return;
+                }
+
+                _Emit(
+                    (Instruction::OpCode)(Instruction::SQRT + (frame.token.GetID() - Token::SQRT)),
+                    frame.argCount
+                );
             }
 
         private:
-            static Real _UnaryPlus(const Real& x) { return x; }
-            static Real _UnaryMinus(const Real& x) { return -x; }
+            void _Emit(Instruction::OpCode opcode, size_t operand = 0) {
+                Instruction instruction;
+                instruction.opcode  = opcode;
+                instruction.operand = (uint32_t)operand;
+                m_program->code.emplace_back(instruction);
+
+                m_depth = m_depth + 1 - instruction.GetArgCount();
+                m_program->stackSize = std::max(m_program->stackSize, m_depth);
+            }
+
+            void _EmitConstant(const Real& value) {
+                m_program->constants.emplace_back(value);
+                m_integerConstants.emplace_back(false, Integer(0));
+                _Emit(Instruction::PUSH_CONSTANT, m_program->constants.size() - 1);
+            }
+
+            void _EmitInteger(const Integer& value) {
+                _EmitConstant(static_cast<Real>(value));
+                m_integerConstants.back() = std::make_pair(true, value);
+            }
+
+        public:
+            // Exact value of each constant of the program, which comes from integer literal
+            const std::vector<std::pair<bool, Integer>>& GetIntegerConstants() const noexcept {
+                return m_integerConstants;
+            }
 
         private:
-            size_t                                       m_index          = 0ull;
-            size_t                                       m_implicitIndex  = 0ull;
-            const Traits*                                m_traits         = nullptr;
-            const std::vector<Token>*                    m_tokens         = nullptr;
-            const std::vector<std::pair<size_t, Token>>* m_implicitTokens = nullptr;
-
-            std::map<Token::ID, Real(*)(const Real&)> m_unaryFunctionMap = {
-                { Token::PLUS,  _UnaryPlus },
-                { Token::MINUS, _UnaryMinus }
-            };
+            size_t             m_index   = 0ull;
+            size_t             m_depth   = 0ull; // of the emitted code
+            const TokenStream* m_tokens  = nullptr;
+            _Program*          m_program = nullptr;
+
+            size_t m_depthLimit = 0;
+            size_t m_nesting    = 0; // subexpressions, which aren't done
+
+            // next payload of each kind
+            size_t m_realPayload    = 0;
+            size_t m_integerPayload = 0;
+            size_t m_indexPayload   = 0;
 
-            std::map<Token::ID, std::function<Real(const Real&, const Real&)>> m_binaryFunctionMap;
-            std::vector<std::function<Real(const std::vector<std::unique_ptr<_ExprNode>>&)>> m_functionMap;
+            ExpressionError m_error      = ExpressionError::IS_VALID;
+            size_t          m_errorToken = 0;
+
+            std::vector<std::pair<bool, Integer>> m_integerConstants;
         };
 
     private:
-        uint64_t m_flags = 0;
+        uint64_t m_flags      = 0;
+        size_t   m_depthLimit = DEFAULT_DEPTH_LIMIT;
 
-        std::map<std::string, Real> m_constantMap = {
-            { "e",  Real(2.718281828459045) },
-            { "pi", Real(3.141592653589793) }
-        };
+        _IdentifierTable  m_identifierTable;
+        std::vector<Real> m_constants;
+        size_t            m_variableCount = 0;
+
+        Traits m_traits;
+
+        std::unique_ptr<_Cache> m_cache;
 
-        Traits   m_traits;
-        _Builder m_builder{ m_traits };
+        mutable _Instrumentation m_instrumentation;
     };
 }
 
-#endif // !PARSER_CORE_PARSER_HEADER
\ No newline at end of file
+#endif // !PARSER_CORE_PARSER_HEADER
@@ -0,0 +1,691 @@
+#ifndef PARSER_CORE_STATIC_EXPRESSION_HEADER
+#define PARSER_CORE_STATIC_EXPRESSION_HEADER
+
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <array>
+#include <string_view>
+
+#include <parser/parser.h>
+
+// Expression parsed at compile time, names after the expression are variables (slots in order of the names):
+//     constexpr auto f = PARSER_STATIC_EXPRESSION("x * sin(y) + 1", "x", "y");
+//     double result = f.Evaluate(values);
+#define PARSER_STATIC_EXPRESSION(...) PARSER_STATIC_EXPRESSION_T(core::ParserBase::DefaultTraits, __VA_ARGS__)
+
+#define PARSER_STATIC_EXPRESSION_T(traits, ...)                                                          \
+    ([] {                                                                                                \
+        struct Source {                                                                                  \
+            static constexpr core::StaticSource Get() { return core::StaticSource(__VA_ARGS__); }        \
+        };                                                                                               \
+        return core::StaticExpression<Source, traits>();                                                 \
+    }())
+
+namespace core {
+    // Text of the static expression and names of its variables
+    struct StaticSource {
+    public:
+        static constexpr size_t s_MaxVariableCount = 32;
+
+    public:
+        template <typename... Names>
+        constexpr StaticSource(std::string_view expression, Names... names) :
+        expression(expression), variables{ std::string_view(names)... }, variableCount(sizeof...(Names)) {
+            static_assert(sizeof...(Names) <= s_MaxVariableCount, "too many variables of static expression");
+        }
+
+    public:
+        std::string_view expression;
+
+        std::array<std::string_view, s_MaxVariableCount> variables = {};
+        size_t                                           variableCount = 0;
+    };
+
+    // Same grammar as Parser with its default constants, builtins are std functions of Real (as in DefaultTraits).
+    // Syntax errors fail compilation with name of the ExpressionError, evaluation is fully inlined
+    template <typename Source, typename Traits = ParserBase::DefaultTraits>
+    class StaticExpression : public ParserBase {
+    public:
+        using Integer = typename Traits::Integer;
+        using Real    = typename Traits::Real;
+
+    public:
+        constexpr StaticExpression() {
+            static_assert(s_Program.error != ExpressionError::TWO_CONSECUTIVE_NUMBERS,
+                "static expression: TWO_CONSECUTIVE_NUMBERS");
+            static_assert(s_Program.error != ExpressionError::INVALID_OPERATOR_PLACE,
+                "static expression: INVALID_OPERATOR_PLACE");
+            static_assert(s_Program.error != ExpressionError::INVALID_PARENTHESES,
+                "static expression: INVALID_PARENTHESES");
+            static_assert(s_Program.error != ExpressionError::INVALID_ARGUMENT_COUNT,
+                "static expression: INVALID_ARGUMENT_COUNT");
+            static_assert(s_Program.error != ExpressionError::INVALID_COMMA_PLACE,
+                "static expression: INVALID_COMMA_PLACE");
+            static_assert(s_Program.error != ExpressionError::INVALID_TOKEN,
+                "static expression: INVALID_TOKEN");
+            static_assert(s_Program.error != ExpressionError::FUNCTION_WITHOUT_PARENTHESES,
+                "static expression: FUNCTION_WITHOUT_PARENTHESES");
+        }
+
+    public:
+        // "variables" must contain at least GetVariableCount() values.
+        // Constant expression, if only arithmetic of compile time constants is used
+        constexpr Real Evaluate(const Real* variables = nullptr) const {
+            if constexpr (s_Program.error == ExpressionError::IS_VALID) {
+                return _Evaluate<s_Program.codeSize - 1>(variables);
+            }
+            else {
+                return Real();
+            }
+        }
+
+        constexpr Real operator()(const Real* variables = nullptr) const { return Evaluate(variables); }
+
+        // Minimal size of the value array (the highest used variable slot + 1)
+        static constexpr size_t GetVariableCount() noexcept { return s_Program.variableCount; }
+
+    private:
+        static constexpr StaticSource s_Source = Source::Get();
+
+        // Upper bound of token count (each token takes at least one char, implicit tokens are inserted between)
+        static constexpr size_t s_Capacity = s_Source.expression.size() * 2 + 2;
+
+        template <typename T, size_t Capacity>
+        class _FixedVector {
+        public:
+            constexpr void push_back(const T& value) { m_data[m_size++] = value; }
+            constexpr void pop_back() { --m_size; }
+
+            constexpr T&       back()       { return m_data[m_size - 1]; }
+            constexpr const T& back() const { return m_data[m_size - 1]; }
+
+            constexpr T&       operator[](size_t i)       { return m_data[i]; }
+            constexpr const T& operator[](size_t i) const { return m_data[i]; }
+
+            constexpr size_t size() const noexcept { return m_size; }
+            constexpr bool empty() const noexcept { return m_size == 0; }
+
+        private:
+            std::array<T, Capacity> m_data = {};
+            size_t                  m_size = 0;
+        };
+
+        struct _Program {
+        public:
+            ExpressionError error = ExpressionError::IS_VALID;
+
+            std::array<Instruction, s_Capacity> code  = {};
+            std::array<size_t, s_Capacity>      sizes = {}; // instruction count of the subexpression ending here
+            size_t                              codeSize = 0;
+
+            // Literals, which can't be converted exactly at compile time, have non-zero length in the source
+            std::array<Real, s_Capacity>     constants      = {};
+            std::array<uint32_t, s_Capacity> literalOffsets = {};
+            std::array<uint32_t, s_Capacity> literalLengths = {};
+            size_t                           constantCount  = 0;
+
+            // Exact values of integer constants
+            std::array<bool, s_Capacity>    isIntegerConstant = {};
+            std::array<Integer, s_Capacity> integerConstants  = {};
+
+            size_t variableCount = 0;
+        };
+
+        class _Builder {
+        public:
+            constexpr _Builder(const _FixedVector<Token, s_Capacity>& tokens, _Program& program) :
+            m_tokens(tokens), m_program(program) {}
+
+        public:
+            // Emit postfix code of the subexpression
+            constexpr void Build(uint8_t rbp) {
+                const Token* token = _Advance();
+                _Nud(token);
+
+                token = _Get();
+                while (!_HasFailed() && token && !token->HasType(Token::EOEX_LIKE) && rbp < token->GetBP()) {
+                    _Advance();
+                    _Led(token);
+                    token = _Get();
+                }
+            }
+
+            // Whole expression must be consumed, up to EOEX (but not past it)
+            constexpr void Finish() {
+                if (_HasFailed()) {
+                    return;
+                }
+                const Token* token = _Get();
+                if (!token) {
+                    _Fail(ExpressionError::INVALID_OPERATOR_PLACE);
+                }
+                else if (!token->Is(Token::EOEX)) {
+                    _Fail(ExpressionError::INVALID_COMMA_PLACE);
+                }
+            }
+
+        private:
+            constexpr const Token* _Advance() {
+                return m_index < m_tokens.size() ? &m_tokens[m_index++] : nullptr;
+            }
+
+            constexpr const Token* _Get() const {
+                return m_index < m_tokens.size() ? &m_tokens[m_index] : nullptr;
+            }
+
+            constexpr bool _HasFailed() const noexcept { return m_program.error != ExpressionError::IS_VALID; }
+            constexpr void _Fail(ExpressionError error) noexcept { m_program.error = error; }
+
+            // Null denotation (begin of the subexpression)
+            constexpr void _Nud(const Token* token) {
+                if (_HasFailed()) {
+                    return;
+                }
+                if (!token) {
+                    _Fail(ExpressionError::INVALID_OPERATOR_PLACE);
+                    return;
+                }
+
+                std::string_view text = s_Source.expression.substr(token->offset, token->length);
+
+                if (token->HasType(Token::VARIABLE)) {
+                    size_t slot = _FindVariable(text);
+                    m_program.variableCount = std::max(m_program.variableCount, slot + 1);
+                    _Emit(Instruction::PUSH_VARIABLE, slot);
+                    return;
+                }
+                if (token->HasType(Token::CONSTANT)) {
+                    for (const std::pair<std::string_view, long double>& constant : s_BuiltinConstants) {
+                        if (constant.first == text) {
+                            _EmitConstant(Real(constant.second), token, false);
+                        }
+                    }
+                    return;
+                }
+                if (token->HasType(Token::NUMBER)) {
+                    Real    value     = Real();
+                    bool    isInteger = false;
+                    Integer integer   = 0;
+
+                    bool isRuntimeLiteral = !_ConvertLiteral(text, value, isInteger, integer);
+                    _EmitConstant(value, token, isRuntimeLiteral);
+
+                    m_program.isIntegerConstant[m_program.constantCount - 1] = isInteger;
+                    m_program.integerConstants[m_program.constantCount - 1]  = integer;
+                    return;
+                }
+                if (token->Is(Token::OPEN_PAREN)) {
+                    Build(0);
+
+                    // parentheses are balanced (checked by validation), comma isn't allowed outside of function call
+                    if (_HasFailed()) {
+                        return;
+                    }
+                    const Token* close = _Advance();
+                    if (!close) {
+                        _Fail(ExpressionError::INVALID_PARENTHESES);
+                    }
+                    else if (!close->Is(Token::CLOSE_PAREN)) {
+                        _Fail(ExpressionError::INVALID_COMMA_PLACE);
+                    }
+                    return;
+                }
+                if (token->HasType(Token::UNARY)) {
+                    Build(token->GetBP());
+                    if (token->Is(Token::MINUS)) { // unary plus doesn't change the value
+                        _Emit(Instruction::NEGATE);
+                    }
+                    return;
+                }
+                if (token->HasType(Token::FUNCTION)) {
+                    size_t argCount = token->GetFunctionArgCount();
+
+                    // otherwise the argument list would end at EOEX and consume it
+                    const Token* next = _Get();
+                    if (!next || !next->Is(Token::OPEN_PAREN)) {
+                        _Fail(ExpressionError::FUNCTION_WITHOUT_PARENTHESES);
+                        return;
+                    }
+                    _Advance(); // skip open paren right after function
+
+                    size_t       args = 0;
+                    const Token* curr = nullptr;
+
+                    next = _Get();
+                    if (next && next->Is(Token::CLOSE_PAREN)) {
+                        _Advance();
+                    }
+                    else {
+                        do {
+                            Build(0);
+                            ++args;
+                            curr = _Advance();
+                        } while (!_HasFailed() && curr && curr->Is(Token::COMMA));
+                    }
+
+                    if (!_HasFailed() && (argCount != args || args == 0)) {
+                        _Fail(ExpressionError::INVALID_ARGUMENT_COUNT);
+                    }
+
+                    _Emit((Instruction::OpCode)(Instruction::SQRT + (token->GetID() - Token::SQRT)), argCount);
+                    return;
+                }
+
+                // Missing operand (e.g. operator right before the end of expression)
+                _Fail(ExpressionError::INVALID_OPERATOR_PLACE);
+            }
+
+            // Left denotation
+            constexpr void _Led(const Token* token) {
+                if (token->HasType(Token::BINARY)) {
+                    Build(token->GetBP());
+                    _Emit((Instruction::OpCode)(Instruction::ADD + (token->GetID() - Token::PLUS)));
+                }
+            }
+
+        private:
+            constexpr void _Emit(Instruction::OpCode opcode, size_t operand = 0) {
+                if (!_HasFailed()) {
+                    _Append(m_program, opcode, operand);
+                }
+            }
+
+            constexpr void _EmitConstant(Real value, const Token* token, bool isRuntimeLiteral) {
+                size_t index = m_program.constantCount++;
+
+                m_program.constants[index] = value;
+                if (isRuntimeLiteral) {
+                    m_program.literalOffsets[index] = token->offset;
+                    m_program.literalLengths[index] = token->length;
+                }
+                _Emit(Instruction::PUSH_CONSTANT, index);
+            }
+
+        private:
+            size_t m_index = 0;
+
+            const _FixedVector<Token, s_Capacity>& m_tokens;
+            _Program&                              m_program;
+        };
+
+    private:
+        static constexpr void _Append(_Program& program, Instruction::OpCode opcode, size_t operand) {
+            Instruction instruction;
+            instruction.opcode  = opcode;
+            instruction.operand = (uint32_t)operand;
+
+            // arguments are the preceding subexpressions
+            size_t size  = 1;
+            size_t index = program.codeSize;
+            for (size_t i = instruction.GetArgCount(); i > 0; --i) {
+                size  += program.sizes[index - 1];
+                index -= program.sizes[index - 1];
+            }
+
+            program.code[program.codeSize]  = instruction;
+            program.sizes[program.codeSize] = size;
+            ++program.codeSize;
+        }
+
+        static constexpr char _CharAt(size_t i) noexcept {
+            return i < s_Source.expression.size() ? s_Source.expression[i] : '\0';
+        }
+
+        // Slot of the first variable with the name (as Parser::DeclareVariable returns existing slot)
+        static constexpr size_t _FindVariable(std::string_view name) noexcept {
+            for (size_t i = 0; i < s_Source.variableCount; ++i) {
+                if (s_Source.variables[i] == name) {
+                    return i;
+                }
+            }
+            return s_Source.variableCount;
+        }
+
+        // Skip spaces and read one token (EOEX at the end of expression, empty token if it's invalid)
+        static constexpr Token _NextToken(size_t& i) noexcept {
+            while (_GetCharacterClass(_CharAt(i)) == SPACE_CHARACTER) ++i;
+
+            size_t begin = i;
+            Token  token;
+
+            switch (_GetCharacterClass(_CharAt(i))) {
+                case END_CHARACTER:
+                    return Token(Token::SYMBOL | (Token::EOEX << Token::ID_BITSHIFT) | Token::EOEX_LIKE, (uint32_t)i, 0);
+
+                case DIGIT_CHARACTER: // number
+                    token.info = Token::INTEGER | Token::NUMBER;
+
+                    while (_GetCharacterClass(_CharAt(i)) == DIGIT_CHARACTER) ++i;
+                    if (_CharAt(i) == '.') {
+                        token.info &= ~Token::INTEGER;
+                        ++i;
+                    }
+
+                    while (_GetCharacterClass(_CharAt(i)) == DIGIT_CHARACTER) ++i;
+                    if (_CharAt(i) == '.') {
+                        return Token();
+                    }
+                    break;
+
+                case LETTER_CHARACTER: { // variable, constant, function
+                    while (_GetCharacterClass(_CharAt(i)) == LETTER_CHARACTER) ++i;
+
+                    std::string_view name = s_Source.expression.substr(begin, i - begin);
+
+                    // variables hide constants
+                    if (_FindVariable(name) < s_Source.variableCount) {
+                        token.info = Token::NUMBER | Token::CONSTANT | Token::VARIABLE;
+                        break;
+                    }
+                    for (const std::pair<std::string_view, long double>& constant : s_BuiltinConstants) {
+                        if (constant.first == name) {
+                            token.info = Token::SYMBOL | Token::NUMBER | Token::CONSTANT;
+                        }
+                    }
+                    if (token.info == 0) {
+                        token.info = _FindBuiltin(name);
+                    }
+                    if (token.info == 0) {
+                        return Token();
+                    }
+                    break;
+                }
+
+                case TOKEN_CHARACTER: // operator, symbol
+                    token.info = s_CharacterTable[(unsigned char)_CharAt(i)].tokenInfo;
+                    ++i;
+                    break;
+
+                default:
+                    return Token();
+            }
+
+            token.offset = (uint32_t)begin;
+            token.length = (uint32_t)(i - begin);
+            return token;
+        }
+
+        // Exact (correctly rounded) conversion of the number literal, false if it can be done only at runtime.
+        // Literal without fraction, which fits Integer, is integer
+        static constexpr bool _ConvertLiteral(std::string_view text, Real& value, bool& isInteger, Integer& integer) noexcept {
+            uint64_t mantissa       = 0;
+            size_t   digitCount     = 0; // significant digits in mantissa
+            size_t   fractionDigits = 0;
+            bool     isFraction     = false;
+
+            for (char c : text) {
+                if (c == '.') {
+                    isFraction = true;
+                    continue;
+                }
+                if (mantissa == 0 && c == '0') {
+                    fractionDigits += isFraction;
+                    continue;
+                }
+                if (++digitCount > std::numeric_limits<uint64_t>::digits10) {
+                    return false;
+                }
+                mantissa = mantissa * 10 + (uint64_t)(c - '0');
+                fractionDigits += isFraction;
+            }
+
+            if (!isFraction && mantissa <= (uint64_t)std::numeric_limits<Integer>::max()) {
+                isInteger = true;
+                integer   = static_cast<Integer>(mantissa);
+                value     = static_cast<Real>(integer);
+                return true;
+            }
+
+            // trailing zeros of the fraction don't change the value
+            while (fractionDigits > 0 && mantissa % 10 == 0) {
+                mantissa /= 10;
+                --fractionDigits;
+            }
+            if (fractionDigits == 0) {
+                value = static_cast<Real>(mantissa);
+                return true;
+            }
+
+            // mantissa and power of 10 are exact, so their quotient is correctly rounded.
+            // Compared as integers, Real(mantissa) would round into the range
+            constexpr int      mantissaBits = std::numeric_limits<Real>::digits;
+            constexpr uint64_t maxExact     = mantissaBits >= 64 ? std::numeric_limits<uint64_t>::max()
+                                                                 : ((uint64_t)1 << (mantissaBits >= 64 ? 0 : mantissaBits));
+            if (mantissa > maxExact) {
+                return false;
+            }
+
+            uint64_t power = 1;
+            for (size_t i = 0; i < fractionDigits; ++i) {
+                if (power > maxExact / 10) { // isn't exact
+                    return false;
+                }
+                power *= 10;
+            }
+
+            value = Real(mantissa) / Real(power);
+            return true;
+        }
+
+        static constexpr _Program _Compile() {
+            _Program program;
+
+            _FixedVector<Token, s_Capacity> tokens;
+
+            _BasicSpecifier<_FixedVector<_VariadicCall, s_Capacity>> specifier;
+            _Validator                                               validator;
+
+            size_t i = 0;
+            while (true) {
+                Token token = _NextToken(i);
+                if (token.info == 0) {
+                    program.error = ExpressionError::INVALID_TOKEN;
+                    return program;
+                }
+
+                if (specifier.IsImplicitMultiplication(token)) {
+                    tokens.push_back(Token(s_CharacterTable['*'].tokenInfo, token.offset, 0));
+                    specifier.Specify(tokens);
+                    validator.Validate(tokens.back()); // always valid after operand
+                }
+
+                tokens.push_back(token);
+                specifier.Specify(tokens);
+
+                program.error = validator.Validate(tokens.back());
+                if (program.error != ExpressionError::IS_VALID) {
+                    return program;
+                }
+
+                if (token.Is(Token::EOEX)) {
+                    break;
+                }
+            }
+
+            program.error = validator.Finish();
+            if (program.error != ExpressionError::IS_VALID) {
+                return program;
+            }
+
+            _Builder builder(tokens, program);
+            builder.Build(0);
+            builder.Finish();
+
+            if (program.error == ExpressionError::IS_VALID) {
+                _FoldIntegers(program);
+            }
+            return program;
+        }
+
+        // Same typing pass as in Parser: integer subexpressions are evaluated exactly and promoted to Real
+        static constexpr void _FoldIntegers(_Program& program) {
+            struct Operand {
+            public:
+                size_t  begin     = 0;
+                bool    isInteger = false;
+                Integer value     = 0;
+            };
+
+            _FixedVector<Operand, s_Capacity> stack;
+
+            _Program source = program;
+            program.codeSize = 0;
+
+            for (size_t i = 0; i < source.codeSize; ++i) {
+                const Instruction& instruction = source.code[i];
+
+                if (instruction.opcode == Instruction::PUSH_CONSTANT || instruction.opcode == Instruction::PUSH_VARIABLE) {
+                    bool isInteger = instruction.opcode == Instruction::PUSH_CONSTANT &&
+                        source.isIntegerConstant[instruction.operand];
+
+                    Integer value = isInteger ? source.integerConstants[instruction.operand] : Integer(0);
+
+                    stack.push_back(Operand{ program.codeSize, isInteger, value });
+                    _Append(program, instruction.opcode, instruction.operand);
+                    continue;
+                }
+
+                size_t argCount = instruction.GetArgCount();
+                size_t first    = stack.size() - argCount;
+                size_t begin    = stack[first].begin;
+
+                bool allInteger = true;
+                for (size_t j = first; j < stack.size(); ++j) {
+                    allInteger = allInteger && stack[j].isInteger;
+                }
+
+                auto getValue = [&stack, first](size_t j) { return stack[first + j].value; };
+
+                Integer result    = 0;
+                bool    isInteger = allInteger && (
+                    _ApplyInteger(instruction.opcode, stack[first].value, stack.back().value, result) ||
+                    _AggregateInteger(instruction.opcode, argCount, getValue, result)
+                );
+
+                while (stack.size() > first) {
+                    stack.pop_back();
+                }
+
+                if (isInteger) {
+                    size_t index = program.constantCount++;
+                    program.constants[index]         = static_cast<Real>(result);
+                    program.isIntegerConstant[index] = true;
+                    program.integerConstants[index]  = result;
+
+                    program.codeSize = begin;
+                    stack.push_back(Operand{ begin, true, result });
+                    _Append(program, Instruction::PUSH_CONSTANT, index);
+                }
+                else {
+                    stack.push_back(Operand{ begin, false, Integer(0) });
+                    _Append(program, instruction.opcode, instruction.operand);
+                }
+            }
+        }
+
+    private:
+        static constexpr _Program s_Program = _Compile();
+
+    private:
+        template <size_t Index>
+        static constexpr Real _Evaluate(const Real* variables) {
+            constexpr Instruction instruction = s_Program.code[Index];
+
+            if constexpr (instruction.opcode == Instruction::PUSH_CONSTANT) {
+                if constexpr (s_Program.literalLengths[instruction.operand] > 0) {
+                    return _LoadRuntimeLiteral<instruction.operand>();
+                }
+                else {
+                    return s_Program.constants[instruction.operand];
+                }
+            }
+            else if constexpr (instruction.opcode == Instruction::PUSH_VARIABLE) {
+                return variables[instruction.operand];
+            }
+            else if constexpr (instruction.opcode >= Instruction::AVG) {
+                return _Aggregate<Index>(variables, std::make_index_sequence<instruction.operand>());
+            }
+            else if constexpr (instruction.GetArgCount() == 2) {
+                constexpr size_t right = Index - 1;
+                constexpr size_t left  = right - s_Program.sizes[right];
+
+                Real a = _Evaluate<left>(variables);
+                Real b = _Evaluate<right>(variables);
+
+                if constexpr (instruction.opcode == Instruction::ADD)           return a + b;
+                else if constexpr (instruction.opcode == Instruction::SUBTRACT) return a - b;
+                else if constexpr (instruction.opcode == Instruction::MULTIPLY) return a * b;
+                else if constexpr (instruction.opcode == Instruction::DIVIDE)   return a / b;
+                else                                                            return std::pow(a, b);
+            }
+            else {
+                Real a = _Evaluate<Index - 1>(variables);
+
+                if constexpr (instruction.opcode == Instruction::NEGATE)    return -a;
+                else if constexpr (instruction.opcode == Instruction::SQRT) return std::sqrt(a);
+                else if constexpr (instruction.opcode == Instruction::SIN)  return std::sin(a);
+                else if constexpr (instruction.opcode == Instruction::COS)  return std::cos(a);
+                else if constexpr (instruction.opcode == Instruction::TAN)  return std::tan(a);
+                else if constexpr (instruction.opcode == Instruction::COT)  return Real(1) / std::tan(a);
+                else                                                        return std::log(a);
+            }
+        }
+
+        // Same order of operations as in Parser
+        template <size_t Index, size_t... ArgIndices>
+        static Real _Aggregate(const Real* variables, std::index_sequence<ArgIndices...>) {
+            using Reduction = VectorKernels::Reduction;
+
+            constexpr Instruction::OpCode opcode = s_Program.code[Index].opcode;
+            constexpr size_t              count  = sizeof...(ArgIndices);
+
+            constexpr std::array<size_t, count> args = _GetArguments<Index, count>();
+            const Real values[count] = { _Evaluate<args[ArgIndices]>(variables)... };
+
+            if constexpr (opcode == Instruction::SUM)      return VectorKernels::ReduceScalar(Reduction::SUM, values, count);
+            else if constexpr (opcode == Instruction::MIN) return VectorKernels::ReduceScalar(Reduction::MIN, values, count);
+            else if constexpr (opcode == Instruction::MAX) return VectorKernels::ReduceScalar(Reduction::MAX, values, count);
+            else {
+                Real mean = VectorKernels::ReduceScalar(Reduction::SUM, values, count) / Real(count);
+                if constexpr (opcode == Instruction::AVG) {
+                    return mean;
+                }
+                else {
+                    Real deviance = VectorKernels::ReduceScalar(Reduction::SUM_SQUARED_DEVIATIONS, values, count, mean);
+                    return std::sqrt(deviance / Real(count));
+                }
+            }
+        }
+
+        // Last instructions of the argument subexpressions
+        template <size_t Index, size_t ArgCount>
+        static constexpr std::array<size_t, ArgCount> _GetArguments() {
+            std::array<size_t, ArgCount> args = {};
+
+            size_t index = Index;
+            for (size_t i = ArgCount; i > 0; --i) {
+                args[i - 1] = index - 1;
+                index -= s_Program.sizes[index - 1];
+            }
+            return args;
+        }
+
+        // Converted once on the first use
+        template <size_t ConstantIndex>
+        static Real _LoadRuntimeLiteral() {
+            static const Real value = [] {
+                Real result = Real();
+                Traits::StringToReal(
+                    s_Source.expression.substr(s_Program.literalOffsets[ConstantIndex], s_Program.literalLengths[ConstantIndex]),
+                    result
+                );
+                return result;
+            }();
+            return value;
+        }
+    };
+}
+
+#endif // !PARSER_CORE_STATIC_EXPRESSION_HEADER
@@ -0,0 +1,69 @@
+#ifndef PARSER_CORE_THREAD_POOL_HEADER
+#define PARSER_CORE_THREAD_POOL_HEADER
+
+#include <cstddef>
+#include <atomic>
+#include <memory>
+#include <functional>
+
+#include <vector>
+#include <deque>
+
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+namespace core {
+    // Each worker has its own task queue, idle workers steal tasks from the other queues
+    class ThreadPool {
+    public:
+        // 0 means count of hardware threads
+        explicit ThreadPool(size_t threadCount = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+    public:
+        void Submit(std::function<void()> task);
+
+        // Call "func(begin, end)" for chunks of [0, count) with at most "grain" elements and wait for all of them,
+        // calling thread executes tasks too
+        void ParallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& func);
+
+        // Same as ParallelFor, but calling thread executes chunks of this call only (idle workers join it),
+        // so it's safe inside a task, which keeps thread-local state (e.g. scratch buffers) over the call
+        void ParallelForIsolated(size_t count, size_t grain, const std::function<void(size_t, size_t)>& func);
+
+        size_t GetThreadCount() const noexcept { return m_threads.size(); }
+
+        // Shared pool sized to the machine
+        static ThreadPool& GetDefault();
+
+    private:
+        struct _Queue {
+        public:
+            std::mutex                        mutex;
+            std::deque<std::function<void()>> tasks;
+        };
+
+    private:
+        void _WorkerLoop(size_t index);
+
+        // Take task from the queue of "index" (own queue first), then from the other queues
+        bool _TryRunTask(size_t index);
+
+    private:
+        std::vector<std::unique_ptr<_Queue>> m_queues;
+        std::vector<std::thread>             m_threads;
+
+        std::mutex              m_sleepMutex;
+        std::condition_variable m_condition;
+
+        std::atomic<size_t> m_pendingCount{ 0 };
+        std::atomic<size_t> m_nextQueue{ 0 };
+        bool                m_stop = false;
+    };
+}
+
+#endif // !PARSER_CORE_THREAD_POOL_HEADER
@@ -0,0 +1,133 @@
+#ifndef PARSER_CORE_VECTOR_KERNELS_HEADER
+#define PARSER_CORE_VECTOR_KERNELS_HEADER
+
+#include <cstddef>
+#include <limits>
+
+namespace core {
+    // Element-wise array operations, "out" may alias any of the inputs
+    struct VectorKernels {
+    public:
+        enum class Level {
+            SCALAR,
+            SSE2,
+            AVX2
+        };
+
+        enum class Reduction {
+            SUM,
+            MIN, // NaN, if any value is NaN
+            MAX, // NaN, if any value is NaN
+            SUM_SQUARED_DEVIATIONS
+        };
+
+        // Reduction of more than REDUCTION_BLOCK_SIZE values is split in two (pairwise), values of the block are
+        // accumulated in REDUCTION_LANE_COUNT lanes (i-th value to lane i % REDUCTION_LANE_COUNT). The order of
+        // operations is fixed, so every level (and ReduceScalar of any real type) gives the same result
+        static constexpr size_t REDUCTION_BLOCK_SIZE = 128;
+        static constexpr size_t REDUCTION_LANE_COUNT = 8;
+
+    public:
+        // Best level supported by the CPU (detected once)
+        static const VectorKernels& Get() noexcept;
+
+        // Specified level, if it is supported, otherwise the best supported level below it
+        static const VectorKernels& Get(Level level) noexcept;
+
+        static Level GetSupportedLevel() noexcept;
+
+    public:
+        // Size of the first half of "n" values (more than REDUCTION_BLOCK_SIZE)
+        static constexpr size_t SplitReduction(size_t n) noexcept {
+            size_t half = n / 2;
+            return half - half % REDUCTION_LANE_COUNT;
+        }
+
+        template <typename T>
+        static constexpr T GetIdentity(Reduction reduction) noexcept {
+            static_assert(std::numeric_limits<T>::has_infinity, "min and max start from infinity");
+
+            switch (reduction) {
+                case Reduction::MIN: return std::numeric_limits<T>::infinity();
+                case Reduction::MAX: return -std::numeric_limits<T>::infinity();
+                default:             return T(0);
+            }
+        }
+
+        // Results of two parts (in order)
+        template <typename T>
+        static constexpr T Combine(Reduction reduction, const T& a, const T& b) noexcept {
+            switch (reduction) {
+                case Reduction::MIN: return (b < a || b != b) ? b : a;
+                case Reduction::MAX: return (b > a || b != b) ? b : a;
+                default:             return a + b;
+            }
+        }
+
+        // Add value "x" to the lane
+        template <typename T>
+        static constexpr T Accumulate(Reduction reduction, const T& lane, const T& x, const T& mean) noexcept {
+            if (reduction == Reduction::SUM_SQUARED_DEVIATIONS) {
+                T deviation = x - mean;
+                return lane + deviation * deviation;
+            }
+            return Combine(reduction, lane, x);
+        }
+
+        template <typename T>
+        static constexpr T CombineLanes(Reduction reduction, const T* lanes) noexcept {
+            static_assert(REDUCTION_LANE_COUNT == 8, "lanes are combined as a tree of 8");
+
+            T a = Combine(reduction, Combine(reduction, lanes[0], lanes[1]), Combine(reduction, lanes[2], lanes[3]));
+            T b = Combine(reduction, Combine(reduction, lanes[4], lanes[5]), Combine(reduction, lanes[6], lanes[7]));
+            return Combine(reduction, a, b);
+        }
+
+        // Definition of the reductions, "n" > 0 ("mean" is used by SUM_SQUARED_DEVIATIONS)
+        template <typename T>
+        static T ReduceScalar(Reduction reduction, const T* x, size_t n, const T& mean = T(0)) {
+            if (n > REDUCTION_BLOCK_SIZE) {
+                size_t half = SplitReduction(n);
+                return Combine(
+                    reduction,
+                    ReduceScalar(reduction, x, half, mean),
+                    ReduceScalar(reduction, x + half, n - half, mean)
+                );
+            }
+
+            T lanes[REDUCTION_LANE_COUNT];
+            for (size_t i = 0; i < REDUCTION_LANE_COUNT; ++i) {
+                lanes[i] = GetIdentity<T>(reduction);
+            }
+            for (size_t i = 0; i < n; ++i) {
+                T& lane = lanes[i % REDUCTION_LANE_COUNT];
+                lane = Accumulate(reduction, lane, x[i], mean);
+            }
+            return CombineLanes(reduction, lanes);
+        }
+
+    public:
+        Level level;
+
+        void(*add)(double* out, const double* x, const double* y, size_t n);
+        void(*subtract)(double* out, const double* x, const double* y, size_t n);
+        void(*multiply)(double* out, const double* x, const double* y, size_t n);
+        void(*divide)(double* out, const double* x, const double* y, size_t n);
+        void(*negate)(double* out, const double* x, size_t n);
+        void(*fill)(double* out, double value, size_t n);
+
+        // Same operations on float (twice as many lanes)
+        void(*addFloat)(float* out, const float* x, const float* y, size_t n);
+        void(*subtractFloat)(float* out, const float* x, const float* y, size_t n);
+        void(*multiplyFloat)(float* out, const float* x, const float* y, size_t n);
+        void(*divideFloat)(float* out, const float* x, const float* y, size_t n);
+        void(*negateFloat)(float* out, const float* x, size_t n);
+        void(*fillFloat)(float* out, float value, size_t n);
+
+        // Same results as ReduceScalar
+        double(*reduce)(Reduction reduction, const double* x, size_t n, double mean);
+        float(*reduceFloat)(Reduction reduction, const float* x, size_t n, float mean);
+    };
+}
+
+#endif // !PARSER_CORE_VECTOR_KERNELS_HEADER
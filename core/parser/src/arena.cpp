@@ -0,0 +1,120 @@
+#include <parser/arena.h>
+
+#include <algorithm>
+#include <cstring>
+
+std::atomic<uint64_t> core::Arena::s_TotalAllocationCount{ 0 };
+
+core::Arena::Arena(size_t blockSize) noexcept : m_blockSize(blockSize) {}
+
+core::Arena::Arena(void* buffer, size_t size, size_t blockSize) noexcept : m_blockSize(blockSize) {
+    uintptr_t begin   = (uintptr_t)buffer;
+    uintptr_t aligned = (begin + alignof(_Block) - 1) & ~(uintptr_t)(alignof(_Block) - 1);
+    if (buffer == nullptr || aligned - begin + sizeof(_Block) >= size) {
+        return;
+    }
+
+    m_head = ::new ((void*)aligned) _Block{ nullptr, size - (aligned - begin), false };
+    m_current = m_head;
+    m_offset  = sizeof(_Block);
+}
+
+core::Arena::Arena(Arena&& other) noexcept :
+m_head(other.m_head),
+m_current(other.m_current),
+m_offset(other.m_offset),
+m_blockSize(other.m_blockSize),
+m_allocationCount(other.m_allocationCount),
+m_usedBytes(other.m_usedBytes) {
+    other.m_head = other.m_current = nullptr;
+    other.m_offset = other.m_usedBytes = 0;
+}
+
+core::Arena::~Arena() {
+    _Free();
+}
+
+core::Arena& core::Arena::operator=(Arena&& other) noexcept {
+    if (this != &other) {
+        _Free();
+
+        m_head            = other.m_head;
+        m_current         = other.m_current;
+        m_offset          = other.m_offset;
+        m_blockSize       = other.m_blockSize;
+        m_allocationCount = other.m_allocationCount;
+        m_usedBytes       = other.m_usedBytes;
+
+        other.m_head = other.m_current = nullptr;
+        other.m_offset = other.m_usedBytes = 0;
+    }
+    return *this;
+}
+
+void* core::Arena::Allocate(size_t size, size_t alignment) {
+    while (true) {
+        if (m_current) {
+            uintptr_t base   = (uintptr_t)m_current;
+            uintptr_t offset = ((base + m_offset + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+            if (offset + size <= m_current->size) {
+                m_offset = offset + size;
+                m_usedBytes += size;
+                return (void*)(base + offset);
+            }
+            // reuse blocks kept after Reset
+            if (m_current->next) {
+                m_current = m_current->next;
+                m_offset  = sizeof(_Block);
+                continue;
+            }
+        }
+
+        _Block* block = _CreateBlock(sizeof(_Block) + size + alignment);
+        if (m_current) {
+            m_current->next = block;
+        }
+        else {
+            m_head = block;
+        }
+        m_current = block;
+        m_offset  = sizeof(_Block);
+    }
+}
+
+std::string_view core::Arena::CopyString(const char* s, size_t length) {
+    char* copy = static_cast<char*>(Allocate(length + 1, 1));
+    memcpy(copy, s, length);
+    copy[length] = '\0';
+    return std::string_view(copy, length);
+}
+
+void core::Arena::Reset() noexcept {
+    m_current   = m_head;
+    m_offset    = sizeof(_Block);
+    m_usedBytes = 0;
+}
+
+uint64_t core::Arena::GetTotalAllocationCount() noexcept {
+    return s_TotalAllocationCount.load(std::memory_order_relaxed);
+}
+
+core::Arena::_Block* core::Arena::_CreateBlock(size_t minSize) {
+    size_t size = std::max(m_blockSize, minSize);
+
+    ++m_allocationCount;
+    s_TotalAllocationCount.fetch_add(1, std::memory_order_relaxed);
+
+    return ::new (::operator new(size)) _Block{ nullptr, size, true };
+}
+
+void core::Arena::_Free() noexcept {
+    _Block* block = m_head;
+    while (block) {
+        _Block* next = block->next;
+        if (block->isOwned) {
+            ::operator delete(block);
+        }
+        block = next;
+    }
+    m_head = m_current = nullptr;
+}
@@ -0,0 +1,390 @@
+#include <parser/expression_file.h>
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+
+    #define PARSER_FILE_MAPPING_SUPPORTED 1
+#else
+    #define PARSER_FILE_MAPPING_SUPPORTED 0
+#endif
+
+// Layout: header, expression records, variable name records, code, constants, strings (sections are 8-byte aligned)
+struct core::ExpressionFile::_Header {
+public:
+    char     magic[8];
+    uint32_t version;
+    uint32_t byteOrder;       // s_ByteOrder as written by the host
+    uint32_t instructionSize; // sizeof(Instruction)
+    uint32_t realSize;        // sizeof(double)
+
+    uint64_t fileSize;
+    uint64_t checksum; // of everything after the header
+
+    uint64_t expressionCount;
+    uint64_t expressionsOffset;
+    uint64_t variableCount;
+    uint64_t variablesOffset;
+    uint64_t codeCount;
+    uint64_t codeOffset;
+    uint64_t constantCount;
+    uint64_t constantsOffset;
+    uint64_t stringsSize;
+    uint64_t stringsOffset;
+};
+
+// Indices are relative to the begin of the section
+struct core::ExpressionFile::_ExpressionRecord {
+public:
+    uint64_t codeBegin;
+    uint64_t constantsBegin;
+    uint64_t sourceOffset;
+
+    uint32_t codeSize;
+    uint32_t constantCount;
+    uint32_t stackSize;
+    uint32_t variableCount;
+    uint32_t sourceLength;
+    uint32_t padding;
+};
+
+struct core::ExpressionFile::_NameRecord {
+public:
+    uint64_t offset;
+    uint64_t length;
+};
+
+namespace {
+    constexpr char     s_Magic[8]  = { 'P', 'R', 'S', 'E', 'X', 'P', 'R', '\0' };
+    constexpr uint32_t s_ByteOrder = 0x01020304;
+
+    constexpr size_t _Align(size_t size) noexcept {
+        return (size + 7) & ~(size_t)7;
+    }
+
+    // Section of "count" elements fits into the file
+    bool _IsInFile(uint64_t offset, uint64_t count, size_t elementSize, size_t fileSize) noexcept {
+        return offset % 8 == 0 && offset <= fileSize && count <= (fileSize - offset) / elementSize;
+    }
+}
+
+core::ExpressionFile::ExpressionFile(ExpressionFile&& other) noexcept :
+m_data(other.m_data),
+m_size(other.m_size),
+m_isMapped(other.m_isMapped),
+m_buffer(std::move(other.m_buffer)),
+m_expressionCount(other.m_expressionCount),
+m_variableCount(other.m_variableCount) {
+    other.m_data     = nullptr;
+    other.m_isMapped = false;
+    other.m_size = other.m_expressionCount = other.m_variableCount = 0;
+}
+
+core::ExpressionFile::~ExpressionFile() {
+    Close();
+}
+
+core::ExpressionFile& core::ExpressionFile::operator=(ExpressionFile&& other) noexcept {
+    if (this != &other) {
+        Close();
+
+        m_data            = other.m_data;
+        m_size            = other.m_size;
+        m_isMapped        = other.m_isMapped;
+        m_buffer          = std::move(other.m_buffer);
+        m_expressionCount = other.m_expressionCount;
+        m_variableCount   = other.m_variableCount;
+
+        other.m_data     = nullptr;
+        other.m_isMapped = false;
+        other.m_size = other.m_expressionCount = other.m_variableCount = 0;
+    }
+    return *this;
+}
+
+core::ExpressionFile::Error core::ExpressionFile::Open(const char* path) {
+    Close();
+
+#if PARSER_FILE_MAPPING_SUPPORTED
+    int file = ::open(path, O_RDONLY);
+    if (file < 0) {
+        return Error::CANT_OPEN;
+    }
+
+    struct stat status;
+    if (fstat(file, &status) != 0) {
+        ::close(file);
+        return Error::CANT_OPEN;
+    }
+    if ((size_t)status.st_size < sizeof(_Header)) {
+        ::close(file);
+        return Error::INVALID_HEADER;
+    }
+
+    void* memory = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    ::close(file);
+    if (memory == MAP_FAILED) {
+        return Error::CANT_OPEN;
+    }
+
+    m_data     = static_cast<const uint8_t*>(memory);
+    m_size     = (size_t)status.st_size;
+    m_isMapped = true;
+#else
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        return Error::CANT_OPEN;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size < (long)sizeof(_Header)) {
+        fclose(file);
+        return Error::INVALID_HEADER;
+    }
+
+    m_buffer.reset(new uint8_t[(size_t)size]);
+    bool isRead = fread(m_buffer.get(), 1, (size_t)size, file) == (size_t)size;
+    fclose(file);
+    if (!isRead) {
+        m_buffer.reset();
+        return Error::CANT_OPEN;
+    }
+
+    m_data = m_buffer.get();
+    m_size = (size_t)size;
+#endif
+
+    Error error = _Validate();
+    if (error != Error::NONE) {
+        Close();
+    }
+    return error;
+}
+
+void core::ExpressionFile::Close() noexcept {
+#if PARSER_FILE_MAPPING_SUPPORTED
+    if (m_isMapped) {
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+    }
+#endif
+    m_buffer.reset();
+
+    m_data     = nullptr;
+    m_isMapped = false;
+    m_size = m_expressionCount = m_variableCount = 0;
+}
+
+core::ExpressionFile::Expression core::ExpressionFile::GetExpression(size_t index) const noexcept {
+    const _Header&           header = *reinterpret_cast<const _Header*>(m_data);
+    const _ExpressionRecord& record = reinterpret_cast<const _ExpressionRecord*>(m_data + header.expressionsOffset)[index];
+
+    Expression expression;
+    expression.code          = reinterpret_cast<const ParserBase::Instruction*>(m_data + header.codeOffset) + record.codeBegin;
+    expression.constants     = reinterpret_cast<const double*>(m_data + header.constantsOffset) + record.constantsBegin;
+    expression.codeSize      = record.codeSize;
+    expression.constantCount = record.constantCount;
+    expression.stackSize     = record.stackSize;
+    expression.variableCount = record.variableCount;
+    expression.source        = std::string_view(
+        reinterpret_cast<const char*>(m_data + header.stringsOffset) + record.sourceOffset, record.sourceLength
+    );
+    return expression;
+}
+
+std::string_view core::ExpressionFile::GetVariableName(size_t slot) const noexcept {
+    const _Header&     header = *reinterpret_cast<const _Header*>(m_data);
+    const _NameRecord& name   = reinterpret_cast<const _NameRecord*>(m_data + header.variablesOffset)[slot];
+
+    return std::string_view(reinterpret_cast<const char*>(m_data + header.stringsOffset) + name.offset, name.length);
+}
+
+core::ExpressionFile::Error core::ExpressionFile::Write(
+    const char* path,
+    const Expression* expressions,
+    size_t count,
+    const std::string_view* variableNames,
+    size_t variableCount
+) {
+    using Instruction = ParserBase::Instruction;
+
+    _Header header = {};
+    memcpy(header.magic, s_Magic, sizeof(s_Magic));
+    header.version         = VERSION;
+    header.byteOrder       = s_ByteOrder;
+    header.instructionSize = sizeof(Instruction);
+    header.realSize        = sizeof(double);
+    header.expressionCount = count;
+    header.variableCount   = variableCount;
+
+    for (size_t i = 0; i < count; ++i) {
+        header.codeCount     += expressions[i].codeSize;
+        header.constantCount += expressions[i].constantCount;
+        header.stringsSize   += expressions[i].source.size();
+    }
+    for (size_t i = 0; i < variableCount; ++i) {
+        header.stringsSize += variableNames[i].size();
+    }
+
+    header.expressionsOffset = _Align(sizeof(_Header));
+    header.variablesOffset   = _Align(header.expressionsOffset + count * sizeof(_ExpressionRecord));
+    header.codeOffset        = _Align(header.variablesOffset + variableCount * sizeof(_NameRecord));
+    header.constantsOffset   = _Align(header.codeOffset + header.codeCount * sizeof(Instruction));
+    header.stringsOffset     = _Align(header.constantsOffset + header.constantCount * sizeof(double));
+    header.fileSize          = _Align(header.stringsOffset + header.stringsSize);
+
+    // zeroed, so padding doesn't change the checksum
+    std::vector<uint8_t> image(header.fileSize, 0);
+    uint8_t*             data = image.data();
+
+    _ExpressionRecord* records   = reinterpret_cast<_ExpressionRecord*>(data + header.expressionsOffset);
+    _NameRecord*       names     = reinterpret_cast<_NameRecord*>(data + header.variablesOffset);
+    uint8_t*           code      = data + header.codeOffset;
+    double*            constants = reinterpret_cast<double*>(data + header.constantsOffset);
+    char*              strings   = reinterpret_cast<char*>(data + header.stringsOffset);
+
+    uint64_t codeCount     = 0;
+    uint64_t constantCount = 0;
+    uint64_t stringsSize   = 0;
+
+    for (size_t i = 0; i < count; ++i) {
+        const Expression&  expression = expressions[i];
+        _ExpressionRecord& record     = records[i];
+
+        record.codeBegin      = codeCount;
+        record.constantsBegin = constantCount;
+        record.sourceOffset   = stringsSize;
+        record.codeSize       = expression.codeSize;
+        record.constantCount  = expression.constantCount;
+        record.stackSize      = expression.stackSize;
+        record.variableCount  = expression.variableCount;
+        record.sourceLength   = (uint32_t)expression.source.size();
+
+        // field by field, padding of Instruction stays zero
+        for (size_t j = 0; j < expression.codeSize; ++j) {
+            uint8_t* instruction = code + (codeCount + j) * sizeof(Instruction);
+            memcpy(instruction + offsetof(Instruction, opcode), &expression.code[j].opcode, sizeof(Instruction::OpCode));
+            memcpy(instruction + offsetof(Instruction, operand), &expression.code[j].operand, sizeof(uint32_t));
+        }
+        std::copy(expression.constants, expression.constants + expression.constantCount, constants + constantCount);
+        memcpy(strings + stringsSize, expression.source.data(), expression.source.size());
+
+        codeCount     += expression.codeSize;
+        constantCount += expression.constantCount;
+        stringsSize   += expression.source.size();
+    }
+
+    for (size_t i = 0; i < variableCount; ++i) {
+        names[i].offset = stringsSize;
+        names[i].length = variableNames[i].size();
+        memcpy(strings + stringsSize, variableNames[i].data(), variableNames[i].size());
+        stringsSize += variableNames[i].size();
+    }
+
+    header.checksum = _Checksum(data + sizeof(_Header), image.size() - sizeof(_Header));
+    memcpy(data, &header, sizeof(_Header));
+
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        return Error::CANT_OPEN;
+    }
+    bool isWritten = fwrite(data, 1, image.size(), file) == image.size();
+    isWritten = fclose(file) == 0 && isWritten;
+
+    return isWritten ? Error::NONE : Error::CANT_WRITE;
+}
+
+core::ExpressionFile::Error core::ExpressionFile::_Validate() noexcept {
+    using Instruction = ParserBase::Instruction;
+
+    const _Header& header = *reinterpret_cast<const _Header*>(m_data);
+    if (memcmp(header.magic, s_Magic, sizeof(s_Magic)) != 0) {
+        return Error::INVALID_HEADER;
+    }
+    if (header.version != VERSION || header.byteOrder != s_ByteOrder ||
+        header.instructionSize != sizeof(Instruction) || header.realSize != sizeof(double)) {
+        return Error::UNSUPPORTED_VERSION;
+    }
+    if (header.fileSize != m_size || m_size % 8 != 0 ||
+        !_IsInFile(header.expressionsOffset, header.expressionCount, sizeof(_ExpressionRecord), m_size) ||
+        !_IsInFile(header.variablesOffset, header.variableCount, sizeof(_NameRecord), m_size) ||
+        !_IsInFile(header.codeOffset, header.codeCount, sizeof(Instruction), m_size) ||
+        !_IsInFile(header.constantsOffset, header.constantCount, sizeof(double), m_size) ||
+        !_IsInFile(header.stringsOffset, header.stringsSize, 1, m_size)) {
+        return Error::INVALID_HEADER;
+    }
+    if (_Checksum(m_data + sizeof(_Header), m_size - sizeof(_Header)) != header.checksum) {
+        return Error::CHECKSUM_MISMATCH;
+    }
+
+    const _ExpressionRecord* records = reinterpret_cast<const _ExpressionRecord*>(m_data + header.expressionsOffset);
+    const _NameRecord*       names   = reinterpret_cast<const _NameRecord*>(m_data + header.variablesOffset);
+    const Instruction*       code    = reinterpret_cast<const Instruction*>(m_data + header.codeOffset);
+
+    for (size_t i = 0; i < header.variableCount; ++i) {
+        if (names[i].offset > header.stringsSize || names[i].length > header.stringsSize - names[i].offset) {
+            return Error::INVALID_PROGRAM;
+        }
+    }
+
+    for (size_t i = 0; i < header.expressionCount; ++i) {
+        const _ExpressionRecord& record = records[i];
+
+        if (record.codeSize == 0 ||
+            record.codeBegin > header.codeCount || record.codeSize > header.codeCount - record.codeBegin ||
+            record.constantsBegin > header.constantCount ||
+            record.constantCount > header.constantCount - record.constantsBegin ||
+            record.sourceOffset > header.stringsSize || record.sourceLength > header.stringsSize - record.sourceOffset ||
+            record.variableCount > header.variableCount) {
+            return Error::INVALID_PROGRAM;
+        }
+
+        // Same stack discipline as the evaluation: every read is in range, one value is left
+        size_t depth    = 0;
+        size_t maxDepth = 0;
+        for (size_t j = 0; j < record.codeSize; ++j) {
+            const Instruction& instruction = code[record.codeBegin + j];
+
+            if (instruction.opcode > Instruction::STDDEV ||
+                (instruction.opcode == Instruction::PUSH_CONSTANT && instruction.operand >= record.constantCount) ||
+                (instruction.opcode == Instruction::PUSH_VARIABLE && instruction.operand >= record.variableCount) ||
+                (instruction.opcode >= Instruction::AVG && instruction.operand == 0)) {
+                return Error::INVALID_PROGRAM;
+            }
+
+            size_t argCount = instruction.GetArgCount();
+            if (argCount > depth) {
+                return Error::INVALID_PROGRAM;
+            }
+            depth = depth + 1 - argCount;
+            maxDepth = std::max(maxDepth, depth);
+        }
+
+        if (depth != 1 || maxDepth > record.stackSize) {
+            return Error::INVALID_PROGRAM;
+        }
+    }
+
+    m_expressionCount = header.expressionCount;
+    m_variableCount   = header.variableCount;
+    return Error::NONE;
+}
+
+// FNV-1a over 64-bit words (sections are padded to 8 bytes)
+uint64_t core::ExpressionFile::_Checksum(const uint8_t* data, size_t size) noexcept {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * 1099511628211ull;
+    }
+    return hash;
+}
@@ -0,0 +1,322 @@
+#include <parser/parser.h>
+
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__))
+    #define PARSER_JIT_SUPPORTED 1
+    #include <sys/mman.h>
+    #include <unistd.h>
+#else
+    #define PARSER_JIT_SUPPORTED 0
+#endif
+
+#include <cstring>
+
+namespace {
+#if PARSER_JIT_SUPPORTED
+    // Machine code with constant pool placed right after it (addressed relative to RIP)
+    class _Assembler {
+    public:
+        _Assembler() {
+            // sign mask for negation (16-byte aligned operand of xorpd)
+            m_pool.push_back(0x8000000000000000ull);
+            m_pool.push_back(0x8000000000000000ull);
+        }
+
+    public:
+        void Emit(std::initializer_list<uint8_t> bytes) {
+            m_code.insert(m_code.end(), bytes.begin(), bytes.end());
+        }
+
+        void EmitImm32(uint32_t value) {
+            for (size_t i = 0; i < 4; ++i) {
+                m_code.push_back((uint8_t)(value >> (i * 8)));
+            }
+        }
+
+        void EmitImm64(uint64_t value) {
+            for (size_t i = 0; i < 8; ++i) {
+                m_code.push_back((uint8_t)(value >> (i * 8)));
+            }
+        }
+
+        // disp32 of RIP-relative operand, it must be the last field of the instruction
+        void EmitPoolReference(size_t poolIndex) {
+            m_fixups.emplace_back(m_code.size(), poolIndex);
+            EmitImm32(0);
+        }
+
+        size_t AddConstant(double value) {
+            uint64_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            m_pool.push_back(bits);
+            return m_pool.size() - 1;
+        }
+
+        // Copy code and pool to executable memory
+        bool Finalize(void*& memory, size_t& size) {
+            size_t poolOffset = (m_code.size() + 15) & ~(size_t)15;
+            size_t pageSize   = (size_t)sysconf(_SC_PAGESIZE);
+
+            size = (poolOffset + m_pool.size() * sizeof(uint64_t) + pageSize - 1) & ~(pageSize - 1);
+            memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (memory == MAP_FAILED) {
+                memory = nullptr;
+                return false;
+            }
+
+            for (const std::pair<size_t, size_t>& fixup : m_fixups) {
+                int64_t target = (int64_t)(poolOffset + fixup.second * sizeof(uint64_t));
+                int64_t next   = (int64_t)(fixup.first + 4);
+                uint32_t disp  = (uint32_t)(int32_t)(target - next);
+                memcpy(&m_code[fixup.first], &disp, sizeof(disp));
+            }
+
+            uint8_t* bytes = static_cast<uint8_t*>(memory);
+            memcpy(bytes, m_code.data(), m_code.size());
+            memcpy(bytes + poolOffset, m_pool.data(), m_pool.size() * sizeof(uint64_t));
+
+            if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+                munmap(memory, size);
+                memory = nullptr;
+                return false;
+            }
+            return true;
+        }
+
+    public:
+        static constexpr size_t SIGN_MASK = 0;
+
+    private:
+        std::vector<uint8_t>                   m_code;
+        std::vector<uint64_t>                  m_pool;
+        std::vector<std::pair<size_t, size_t>> m_fixups; // code offset, pool index
+    };
+
+    // Instructions of the stack machine (top of the stack is kept in xmm0, other values are in the frame)
+
+    void _LoadSlot(_Assembler& a, size_t slot) { // movsd xmm0, [rsp + disp32]
+        a.Emit({ 0xF2, 0x0F, 0x10, 0x84, 0x24 });
+        a.EmitImm32((uint32_t)(slot * sizeof(double)));
+    }
+
+    void _StoreSlot(_Assembler& a, size_t slot) { // movsd [rsp + disp32], xmm0
+        a.Emit({ 0xF2, 0x0F, 0x11, 0x84, 0x24 });
+        a.EmitImm32((uint32_t)(slot * sizeof(double)));
+    }
+
+    void _LoadVariable(_Assembler& a, size_t slot) { // movsd xmm0, [rbx + disp32]
+        a.Emit({ 0xF2, 0x0F, 0x10, 0x83 });
+        a.EmitImm32((uint32_t)(slot * sizeof(double)));
+    }
+
+    void _LoadConstant(_Assembler& a, size_t poolIndex) { // movsd xmm0, [rip + disp32]
+        a.Emit({ 0xF2, 0x0F, 0x10, 0x05 });
+        a.EmitPoolReference(poolIndex);
+    }
+
+    // xmm1 = xmm0 (right operand), xmm0 = left operand
+    void _LoadOperands(_Assembler& a, size_t leftSlot) {
+        a.Emit({ 0x66, 0x0F, 0x28, 0xC8 }); // movapd xmm1, xmm0
+        _LoadSlot(a, leftSlot);
+    }
+
+    void _Call(_Assembler& a, const void* function) {
+        a.Emit({ 0x48, 0xB8 }); // mov rax, imm64
+        a.EmitImm64((uint64_t)(uintptr_t)function);
+        a.Emit({ 0xFF, 0xD0 }); // call rax
+    }
+#endif
+}
+
+core::JitFunction::JitFunction(JitFunction&& other) noexcept :
+m_function(other.m_function),
+m_memory(other.m_memory),
+m_size(other.m_size) {
+    other.m_function = nullptr;
+    other.m_memory   = nullptr;
+    other.m_size     = 0;
+}
+
+core::JitFunction::~JitFunction() {
+    _Free();
+}
+
+core::JitFunction& core::JitFunction::operator=(JitFunction&& other) noexcept {
+    if (this != &other) {
+        _Free();
+
+        m_function = other.m_function;
+        m_memory   = other.m_memory;
+        m_size     = other.m_size;
+
+        other.m_function = nullptr;
+        other.m_memory   = nullptr;
+        other.m_size     = 0;
+    }
+    return *this;
+}
+
+bool core::JitFunction::IsSupported() noexcept {
+    return PARSER_JIT_SUPPORTED;
+}
+
+core::JitFunction core::JitFunction::Compile(
+const ParserBase::Instruction* code,
+size_t codeSize,
+const double* constants,
+size_t stackSize,
+const Calls& calls) {
+    JitFunction result;
+
+#if PARSER_JIT_SUPPORTED
+    using Instruction = ParserBase::Instruction;
+
+    // values are kept in the native stack frame
+    static constexpr size_t s_MaxFrameSize = 1 << 16;
+
+    size_t frameSize = (std::max<size_t>(stackSize, 1) * sizeof(double) + 15) & ~(size_t)15;
+    if (frameSize > s_MaxFrameSize) {
+        return result;
+    }
+
+    _Assembler a;
+    size_t one = a.AddConstant(1.0);
+
+    a.Emit({ 0x53 });             // push rbx
+    a.Emit({ 0x48, 0x89, 0xFB }); // mov rbx, rdi (variables)
+    a.Emit({ 0x48, 0x81, 0xEC }); // sub rsp, imm32
+    a.EmitImm32((uint32_t)frameSize);
+
+    // count of values on the stack, top value is in xmm0
+    size_t depth = 0;
+
+    for (size_t i = 0; i < codeSize; ++i) {
+        const Instruction& instruction = code[i];
+
+        switch (instruction.opcode) {
+            case Instruction::PUSH_CONSTANT:
+            case Instruction::PUSH_VARIABLE:
+                if (depth > 0) {
+                    _StoreSlot(a, depth - 1);
+                }
+                if (instruction.opcode == Instruction::PUSH_CONSTANT) {
+                    _LoadConstant(a, a.AddConstant(constants[instruction.operand]));
+                }
+                else {
+                    _LoadVariable(a, instruction.operand);
+                }
+                ++depth;
+                break;
+
+            case Instruction::NEGATE:
+                a.Emit({ 0x66, 0x0F, 0x57, 0x05 }); // xorpd xmm0, [rip + disp32]
+                a.EmitPoolReference(_Assembler::SIGN_MASK);
+                break;
+
+            case Instruction::ADD:
+            case Instruction::SUBTRACT:
+            case Instruction::MULTIPLY:
+            case Instruction::DIVIDE: {
+                static const uint8_t s_opcodes[] = { 0x58, 0x5C, 0x59, 0x5E }; // addsd, subsd, mulsd, divsd
+
+                _LoadOperands(a, depth - 2);
+                a.Emit({ 0xF2, 0x0F, s_opcodes[instruction.opcode - Instruction::ADD], 0xC1 }); // op xmm0, xmm1
+                --depth;
+                break;
+            }
+
+            case Instruction::POWER:
+            case Instruction::POW:
+                _LoadOperands(a, depth - 2);
+                _Call(a, (const void*)calls.powFunction);
+                --depth;
+                break;
+
+            case Instruction::SQRT: _Call(a, (const void*)calls.sqrtFunction); break;
+            case Instruction::SIN:  _Call(a, (const void*)calls.sinFunction);  break;
+            case Instruction::COS:  _Call(a, (const void*)calls.cosFunction);  break;
+            case Instruction::TAN:  _Call(a, (const void*)calls.tanFunction);  break;
+            case Instruction::LN:   _Call(a, (const void*)calls.lnFunction);   break;
+
+            case Instruction::COT:
+                if (calls.cotFunction) {
+                    _Call(a, (const void*)calls.cotFunction);
+                }
+                else { // 1 / tan
+                    _Call(a, (const void*)calls.tanFunction);
+                    a.Emit({ 0x66, 0x0F, 0x28, 0xC8 }); // movapd xmm1, xmm0
+                    _LoadConstant(a, one);
+                    a.Emit({ 0xF2, 0x0F, 0x5E, 0xC1 }); // divsd xmm0, xmm1
+                }
+                break;
+
+            case Instruction::AVG:
+            case Instruction::SUM: {
+                // one block of the interpreter's reduction: value i is added to lane xmm(i % 8), lanes are added
+                // as a tree, larger sums are left to the interpreter (vector kernels)
+                size_t argCount = instruction.operand;
+                if (argCount > VectorKernels::REDUCTION_BLOCK_SIZE) {
+                    return result;
+                }
+                _StoreSlot(a, depth - 1);
+
+                static_assert(VectorKernels::REDUCTION_LANE_COUNT == 8, "lane is xmm0-xmm7");
+                for (uint8_t lane = 0; lane < 8; ++lane) {
+                    a.Emit({ 0x66, 0x0F, 0x57, (uint8_t)(0xC0 | (lane << 3) | lane) }); // xorpd xmm(lane), xmm(lane)
+                }
+                for (size_t j = 0; j < argCount; ++j) {
+                    uint8_t lane = (uint8_t)(j % 8);
+                    a.Emit({ 0xF2, 0x0F, 0x58, (uint8_t)(0x84 | (lane << 3)), 0x24 }); // addsd xmm(lane), [rsp + disp32]
+                    a.EmitImm32((uint32_t)((depth - argCount + j) * sizeof(double)));
+                }
+
+                a.Emit({ 0xF2, 0x0F, 0x58, 0xC1 }); // addsd xmm0, xmm1
+                a.Emit({ 0xF2, 0x0F, 0x58, 0xD3 }); // addsd xmm2, xmm3
+                a.Emit({ 0xF2, 0x0F, 0x58, 0xE5 }); // addsd xmm4, xmm5
+                a.Emit({ 0xF2, 0x0F, 0x58, 0xF7 }); // addsd xmm6, xmm7
+                a.Emit({ 0xF2, 0x0F, 0x58, 0xC2 }); // addsd xmm0, xmm2
+                a.Emit({ 0xF2, 0x0F, 0x58, 0xE6 }); // addsd xmm4, xmm6
+                a.Emit({ 0xF2, 0x0F, 0x58, 0xC4 }); // addsd xmm0, xmm4
+
+                if (instruction.opcode == Instruction::AVG) {
+                    a.Emit({ 0xF2, 0x0F, 0x5E, 0x05 }); // divsd xmm0, [rip + disp32]
+                    a.EmitPoolReference(a.AddConstant((double)argCount));
+                }
+
+                depth = depth - argCount + 1;
+                break;
+            }
+
+            default: // min, max and stddev are left to the interpreter
+                return result;
+        }
+    }
+
+    a.Emit({ 0x48, 0x81, 0xC4 }); // add rsp, imm32
+    a.EmitImm32((uint32_t)frameSize);
+    a.Emit({ 0x5B }); // pop rbx
+    a.Emit({ 0xC3 }); // ret
+
+    if (a.Finalize(result.m_memory, result.m_size)) {
+        result.m_function = (Function)result.m_memory;
+    }
+#else
+    (void)code;
+    (void)codeSize;
+    (void)constants;
+    (void)stackSize;
+    (void)calls;
+#endif
+
+    return result;
+}
+
+void core::JitFunction::_Free() noexcept {
+#if PARSER_JIT_SUPPORTED
+    if (m_memory) {
+        munmap(m_memory, m_size);
+    }
+#endif
+    m_function = nullptr;
+    m_memory   = nullptr;
+    m_size     = 0;
+}
@@ -1,8 +1,19 @@
 #include <parser/parser.h>
 
 #include <cmath>
-
-core::ParserBase::DefaultTraits::DefaultTraits() :
+#include <charconv>
+
+#ifdef PARSER_INSTRUMENTATION
+    #if defined(__x86_64__) || defined(__i386__)
+        #include <x86intrin.h>
+    #else
+        #include <chrono>
+    #endif
+#endif
+
+// Overloads of the standard functions are selected by the type of the pointer
+template <typename RealT>
+core::ParserBase::BasicTraits<RealT>::BasicTraits() :
 sqrtFunction(std::sqrt),
 powFunction(std::pow),
 sinFunction(std::sin),
@@ -11,86 +22,154 @@ tanFunction(std::tan),
 lnFunction(std::log)
 {}
 
-core::ParserBase::DefaultTraits::Integer core::ParserBase::DefaultTraits::StringToInteger(
-const std::string& s) {
-    return std::stol(s);
-}
-
-core::ParserBase::DefaultTraits::Real core::ParserBase::DefaultTraits::StringToReal(
-const std::string& s) {
-    return std::stod(s);
-}
-
-bool core::ParserBase::Token::HasType(uint64_t type) const noexcept {
-    return (info & type) == type;
+template <typename RealT>
+bool core::ParserBase::BasicTraits<RealT>::StringToInteger(std::string_view s, Integer& result) noexcept {
+    std::from_chars_result r = std::from_chars(s.data(), s.data() + s.size(), result);
+    return r.ec == std::errc() && r.ptr == s.data() + s.size();
 }
 
-bool core::ParserBase::Token::Is(ID id) const noexcept {
-    return ((info >> ID_BITSHIFT) & ID_BITMASK) == id;
+// Decimal is rounded directly to RealT (parsing as double and narrowing to float could round twice)
+template <typename RealT>
+bool core::ParserBase::BasicTraits<RealT>::StringToReal(std::string_view s, Real& result) noexcept {
+    std::from_chars_result r = std::from_chars(s.data(), s.data() + s.size(), result, std::chars_format::fixed);
+    return r.ec == std::errc() && r.ptr == s.data() + s.size();
 }
 
-uint8_t core::ParserBase::Token::GetBP() const noexcept {
-    return (info >> BINDING_POWER_BITSHIFT) & BINDING_POWER_BITMASK;
+template struct core::ParserBase::BasicTraits<float>;
+template struct core::ParserBase::BasicTraits<double>;
+template struct core::ParserBase::BasicTraits<long double>;
+
+void core::ParserBase::_NormalizeExpression(const char* expression, std::string& result) {
+    auto isWordChar = [](char c) {
+        CharacterClass characterClass = _GetCharacterClass(c);
+        return characterClass == DIGIT_CHARACTER || characterClass == LETTER_CHARACTER || c == '.';
+    };
+
+    result.clear();
+
+    bool hasSpace = false;
+    for (size_t i = 0; expression[i] != '\0'; ++i) {
+        char c = expression[i];
+        if (_GetCharacterClass(c) == SPACE_CHARACTER) {
+            hasSpace = true;
+            continue;
+        }
+
+        // space between two numbers or identifiers is significant
+        if (hasSpace && !result.empty() && isWordChar(result.back()) && isWordChar(c)) {
+            result.push_back(' ');
+        }
+        result.push_back(c);
+        hasSpace = false;
+    }
 }
 
-uint8_t core::ParserBase::Token::GetBP2() const noexcept {
-    return (info >> (BINDING_POWER_BITSHIFT + BINDING_POWER_BITS)) & BINDING_POWER_BITMASK;
+// Same walk as _NormalizeExpression, which counts chars instead of writing them
+size_t core::ParserBase::_GetSourceOffset(const char* expression, size_t normalizedOffset) noexcept {
+    auto isWordChar = [](char c) {
+        CharacterClass characterClass = _GetCharacterClass(c);
+        return characterClass == DIGIT_CHARACTER || characterClass == LETTER_CHARACTER || c == '.';
+    };
+
+    size_t count    = 0;
+    char   last     = '\0';
+    bool   hasSpace = false;
+
+    size_t i = 0;
+    for (; expression[i] != '\0'; ++i) {
+        char c = expression[i];
+        if (_GetCharacterClass(c) == SPACE_CHARACTER) {
+            hasSpace = true;
+            continue;
+        }
+
+        if (hasSpace && count > 0 && isWordChar(last) && isWordChar(c)) {
+            if (count++ == normalizedOffset) {
+                return i - 1; // the kept space
+            }
+        }
+        if (count++ == normalizedOffset) {
+            return i;
+        }
+        last     = c;
+        hasSpace = false;
+    }
+    return i;
 }
 
-core::ParserBase::Token::ID core::ParserBase::Token::GetID() const noexcept {
-    return (ID)((info >> ID_BITSHIFT) & ID_BITMASK);
+core::ParserBase::_IdentifierTable::Entry& core::ParserBase::_IdentifierTable::Insert(std::string_view name) {
+    if (Entry* entry = const_cast<Entry*>(Find(name))) {
+        return *entry;
+    }
+
+    // keep load factor under 1/2
+    if ((m_size + 1) * 2 > m_entries.size()) {
+        std::vector<Entry> entries(std::max<size_t>(m_entries.size() * 2, 16));
+        std::swap(entries, m_entries);
+
+        size_t mask = m_entries.size() - 1;
+        for (Entry& entry : entries) {
+            if (entry.info != 0) {
+                size_t i = entry.hash & mask;
+                while (m_entries[i].info != 0) i = (i + 1) & mask;
+                m_entries[i] = std::move(entry);
+            }
+        }
+    }
+
+    uint64_t hash = _Hash(name);
+    size_t   mask = m_entries.size() - 1;
+    size_t   i    = hash & mask;
+    while (m_entries[i].info != 0) i = (i + 1) & mask;
+
+    ++m_size;
+    m_entries[i].name = std::string(name);
+    m_entries[i].hash = hash;
+    return m_entries[i];
 }
 
-size_t core::ParserBase::Token::GetFunctionArgCount() const noexcept {
-    return (info >> FUNCTION_ARGS_BITSHIFT) & FUNCTION_ARGS_BITMASK;
+#ifdef PARSER_INSTRUMENTATION
+core::ParserBase::Statistics core::ParserBase::_Instrumentation::GetSnapshot() const noexcept {
+    Statistics statistics;
+
+    for (size_t i = 0; i < Statistics::STAGE_COUNT; ++i) {
+        statistics.stageCycles[i] = m_stageCycles[i].load(std::memory_order_relaxed);
+    }
+    statistics.compileCount        = m_compileCount.load(std::memory_order_relaxed);
+    statistics.evaluationCount     = m_evaluationCount.load(std::memory_order_relaxed);
+    statistics.tokenCount          = m_tokenCount.load(std::memory_order_relaxed);
+    statistics.nodeCount           = m_nodeCount.load(std::memory_order_relaxed);
+    statistics.maxDepth            = m_maxDepth.load(std::memory_order_relaxed);
+    statistics.heapAllocationCount = m_heapAllocationCount.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < (size_t)ExpressionError::COUNT; ++i) {
+        statistics.errorCounts[i] = m_errorCounts[i].load(std::memory_order_relaxed);
+    }
+
+    return statistics;
 }
 
-void core::ParserBase::Token::SetBP(uint8_t bp) noexcept {
-    info &= ~(BINDING_POWER_BITMASK << BINDING_POWER_BITSHIFT);
-    info |= (uint64_t)bp << BINDING_POWER_BITSHIFT;
+void core::ParserBase::_Instrumentation::_Assign(const Statistics& statistics) noexcept {
+    for (size_t i = 0; i < Statistics::STAGE_COUNT; ++i) {
+        m_stageCycles[i].store(statistics.stageCycles[i], std::memory_order_relaxed);
+    }
+    m_compileCount.store(statistics.compileCount, std::memory_order_relaxed);
+    m_evaluationCount.store(statistics.evaluationCount, std::memory_order_relaxed);
+    m_tokenCount.store(statistics.tokenCount, std::memory_order_relaxed);
+    m_nodeCount.store(statistics.nodeCount, std::memory_order_relaxed);
+    m_maxDepth.store(statistics.maxDepth, std::memory_order_relaxed);
+    m_heapAllocationCount.store(statistics.heapAllocationCount, std::memory_order_relaxed);
+    for (size_t i = 0; i < (size_t)ExpressionError::COUNT; ++i) {
+        m_errorCounts[i].store(statistics.errorCounts[i], std::memory_order_relaxed);
+    }
 }
 
-void core::ParserBase::Token::SetFunctionArgCount(size_t count) noexcept {
-    info &= ~(FUNCTION_ARGS_BITMASK << FUNCTION_ARGS_BITSHIFT);
-    info |= count << FUNCTION_ARGS_BITSHIFT;
+uint64_t core::ParserBase::_Instrumentation::_ReadCycles() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+#endif
 }
-
-uint64_t core::ParserBase::CreateFunctionTokenInfo(Token::ID id, size_t argCount) noexcept {
-    return Token::FUNCTION | Token::SYMBOL | (id << Token::ID_BITSHIFT) |
-        ((30) << Token::BINDING_POWER_BITSHIFT) | (argCount << Token::FUNCTION_ARGS_BITSHIFT);
-}
-
-uint64_t core::ParserBase::CreateOperatorTokenInfo(Token::ID id, uint8_t bp, uint8_t bp2) noexcept {
-    return Token::OPERATOR | Token::SYMBOL | (id << Token::ID_BITSHIFT) |
-        ((((uint64_t)bp2 << Token::BINDING_POWER_BITS) | bp) << Token::BINDING_POWER_BITSHIFT);
-}
-
-std::map<std::string, uint64_t> core::ParserBase::s_FunctionMap = {
-    { "sqrt", CreateFunctionTokenInfo(Token::SQRT, 1) },
-    { "sin",  CreateFunctionTokenInfo(Token::SIN, 1) },
-    { "cos",  CreateFunctionTokenInfo(Token::COS, 1) },
-    { "tan",  CreateFunctionTokenInfo(Token::TAN, 1) },
-    { "cot",  CreateFunctionTokenInfo(Token::COT, 1) },
-    { "ln",   CreateFunctionTokenInfo(Token::LN,  1) },
-
-    // 2 args
-    { "pow", CreateFunctionTokenInfo(Token::POW, 2) },
-
-    // any arg count
-    { "avg", CreateFunctionTokenInfo(Token::AVG, 0) | Token::ANY_ARG_COUNT }
-};
-
-std::map<char, uint64_t> core::ParserBase::s_OperatorMap = {
-    { '+', CreateOperatorTokenInfo(Token::PLUS,  10, 15) | Token::BINARY | Token::UNARY },
-    { '-', CreateOperatorTokenInfo(Token::MINUS, 10, 15) | Token::BINARY | Token::UNARY },
-    { '*', CreateOperatorTokenInfo(Token::ASTERISK, 20)  | Token::BINARY },
-    { '/', CreateOperatorTokenInfo(Token::SLASH,    20)  | Token::BINARY },
-
-    { '^', CreateOperatorTokenInfo(Token::CARET, 25)     | Token::BINARY }
-};
-
-std::map<char, uint64_t> core::ParserBase::s_SupportedSymbolMap = {
-    { '(', Token::SYMBOL | (Token::OPEN_PAREN  << Token::ID_BITSHIFT) },
-    { ')', Token::SYMBOL | (Token::CLOSE_PAREN << Token::ID_BITSHIFT) | Token::EOEX_LIKE },
-    { ',', Token::SYMBOL | (Token::COMMA       << Token::ID_BITSHIFT) | Token::EOEX_LIKE }
-};
\ No newline at end of file
+#endif
@@ -0,0 +1,177 @@
+#include <parser/thread_pool.h>
+
+#include <algorithm>
+
+namespace {
+    // Pool and queue of the current worker thread
+    thread_local const core::ThreadPool* s_CurrentPool  = nullptr;
+    thread_local size_t                  s_CurrentQueue = 0;
+}
+
+core::ThreadPool::ThreadPool(size_t threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    m_queues.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        m_queues.emplace_back(std::make_unique<_Queue>());
+    }
+
+    m_threads.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        m_threads.emplace_back(&ThreadPool::_WorkerLoop, this, i);
+    }
+}
+
+core::ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stop = true;
+    }
+    m_condition.notify_all();
+
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void core::ThreadPool::Submit(std::function<void()> task) {
+    // tasks spawned by a worker go to its own queue
+    size_t index = s_CurrentPool == this ? s_CurrentQueue :
+        m_nextQueue.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_pendingCount.fetch_add(1, std::memory_order_release);
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+        m_queues[index]->tasks.emplace_back(std::move(task));
+    }
+    m_condition.notify_one();
+}
+
+void core::ThreadPool::ParallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& func) {
+    if (count == 0) {
+        return;
+    }
+    grain = std::max<size_t>(grain, 1);
+
+    size_t chunkCount = (count + grain - 1) / grain;
+    if (chunkCount == 1) {
+        func(0, count);
+        return;
+    }
+
+    std::atomic<size_t> remaining{ chunkCount };
+    for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+        size_t begin = chunk * grain;
+        size_t end   = std::min(count, begin + grain);
+        Submit([&func, &remaining, begin, end]() {
+            func(begin, end);
+            remaining.fetch_sub(1, std::memory_order_acq_rel);
+        });
+    }
+
+    size_t index = s_CurrentPool == this ? s_CurrentQueue : 0;
+    while (remaining.load(std::memory_order_acquire) > 0) {
+        if (!_TryRunTask(index)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void core::ThreadPool::ParallelForIsolated(size_t count, size_t grain, const std::function<void(size_t, size_t)>& func) {
+    if (count == 0) {
+        return;
+    }
+    grain = std::max<size_t>(grain, 1);
+
+    size_t chunkCount = (count + grain - 1) / grain;
+    if (chunkCount == 1) {
+        func(0, count);
+        return;
+    }
+
+    // Helpers may start after the call returns, then they find no chunk left and don't touch "func"
+    struct State {
+    public:
+        std::atomic<size_t> nextChunk{ 0 };
+        std::atomic<size_t> doneCount{ 0 };
+    };
+    std::shared_ptr<State> state = std::make_shared<State>();
+
+    auto runChunks = [state, &func, count, grain, chunkCount]() {
+        for (size_t chunk; (chunk = state->nextChunk.fetch_add(1, std::memory_order_relaxed)) < chunkCount;) {
+            size_t begin = chunk * grain;
+            func(begin, std::min(count, begin + grain));
+            state->doneCount.fetch_add(1, std::memory_order_acq_rel);
+        }
+    };
+
+    size_t helperCount = std::min(m_threads.size(), chunkCount - 1);
+    for (size_t i = 0; i < helperCount; ++i) {
+        Submit(runChunks);
+    }
+
+    runChunks();
+    while (state->doneCount.load(std::memory_order_acquire) < chunkCount) {
+        std::this_thread::yield();
+    }
+}
+
+core::ThreadPool& core::ThreadPool::GetDefault() {
+    static ThreadPool s_pool;
+    return s_pool;
+}
+
+void core::ThreadPool::_WorkerLoop(size_t index) {
+    s_CurrentPool  = this;
+    s_CurrentQueue = index;
+
+    while (true) {
+        if (_TryRunTask(index)) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_condition.wait(lock, [this]() {
+            return m_stop || m_pendingCount.load(std::memory_order_acquire) > 0;
+        });
+        if (m_stop && m_pendingCount.load(std::memory_order_acquire) == 0) {
+            return;
+        }
+    }
+}
+
+bool core::ThreadPool::_TryRunTask(size_t index) {
+    std::function<void()> task;
+
+    size_t queueCount = m_queues.size();
+    for (size_t i = 0; i < queueCount && !task; ++i) {
+        _Queue& queue = *m_queues[(index + i) % queueCount];
+
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            continue;
+        }
+        // newest own task (cache-warm), oldest task of the other queue
+        if (i == 0) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        else {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+    }
+
+    if (!task) {
+        return false;
+    }
+
+    m_pendingCount.fetch_sub(1, std::memory_order_acq_rel);
+    task();
+    return true;
+}
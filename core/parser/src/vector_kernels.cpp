@@ -0,0 +1,547 @@
+#include <parser/vector_kernels.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    #define PARSER_VECTOR_KERNELS_X86 1
+    #include <immintrin.h>
+#else
+    #define PARSER_VECTOR_KERNELS_X86 0
+#endif
+
+namespace {
+    // Scalar
+
+    template <typename T>
+    void _AddScalar(T* out, const T* x, const T* y, size_t n) {
+        for (size_t i = 0; i < n; ++i) out[i] = x[i] + y[i];
+    }
+
+    template <typename T>
+    void _SubtractScalar(T* out, const T* x, const T* y, size_t n) {
+        for (size_t i = 0; i < n; ++i) out[i] = x[i] - y[i];
+    }
+
+    template <typename T>
+    void _MultiplyScalar(T* out, const T* x, const T* y, size_t n) {
+        for (size_t i = 0; i < n; ++i) out[i] = x[i] * y[i];
+    }
+
+    template <typename T>
+    void _DivideScalar(T* out, const T* x, const T* y, size_t n) {
+        for (size_t i = 0; i < n; ++i) out[i] = x[i] / y[i];
+    }
+
+    template <typename T>
+    void _NegateScalar(T* out, const T* x, size_t n) {
+        for (size_t i = 0; i < n; ++i) out[i] = -x[i];
+    }
+
+    template <typename T>
+    void _FillScalar(T* out, T value, size_t n) {
+        for (size_t i = 0; i < n; ++i) out[i] = value;
+    }
+
+    using Reduction = core::VectorKernels::Reduction;
+
+    template <typename T>
+    T _ReduceScalar(Reduction reduction, const T* x, size_t n, T mean) {
+        return core::VectorKernels::ReduceScalar(reduction, x, n, mean);
+    }
+
+    // Pairwise split of ReduceScalar, "block" reduces at most REDUCTION_BLOCK_SIZE values
+    template <typename T, typename Block>
+    T _ReducePairwise(Reduction reduction, const T* x, size_t n, T mean, Block block) {
+        if (n > core::VectorKernels::REDUCTION_BLOCK_SIZE) {
+            size_t half = core::VectorKernels::SplitReduction(n);
+            return core::VectorKernels::Combine(
+                reduction,
+                _ReducePairwise(reduction, x, half, mean, block),
+                _ReducePairwise(reduction, x + half, n - half, mean, block)
+            );
+        }
+        return block(reduction, x, n, mean);
+    }
+
+    // Values after the vector part (which filled whole groups of lanes) and combination of the lanes
+    template <typename T>
+    T _FinishBlock(Reduction reduction, T* lanes, const T* x, size_t i, size_t n, T mean) {
+        for (; i < n; ++i) {
+            T& lane = lanes[i % core::VectorKernels::REDUCTION_LANE_COUNT];
+            lane = core::VectorKernels::Accumulate(reduction, lane, x[i], mean);
+        }
+        return core::VectorKernels::CombineLanes(reduction, lanes);
+    }
+
+#if PARSER_VECTOR_KERNELS_X86
+    // SSE2 (always available on x86-64)
+
+    void _AddSSE2(double* out, const double* x, const double* y, size_t n) {
+        size_t i = 0;
+        for (; i + 2 <= n; i += 2) {
+            _mm_storeu_pd(out + i, _mm_add_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i)));
+        }
+        _AddScalar(out + i, x + i, y + i, n - i);
+    }
+
+    void _SubtractSSE2(double* out, const double* x, const double* y, size_t n) {
+        size_t i = 0;
+        for (; i + 2 <= n; i += 2) {
+            _mm_storeu_pd(out + i, _mm_sub_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i)));
+        }
+        _SubtractScalar(out + i, x + i, y + i, n - i);
+    }
+
+    void _MultiplySSE2(double* out, const double* x, const double* y, size_t n) {
+        size_t i = 0;
+        for (; i + 2 <= n; i += 2) {
+            _mm_storeu_pd(out + i, _mm_mul_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i)));
+        }
+        _MultiplyScalar(out + i, x + i, y + i, n - i);
+    }
+
+    void _DivideSSE2(double* out, const double* x, const double* y, size_t n) {
+        size_t i = 0;
+        for (; i + 2 <= n; i += 2) {
+            _mm_storeu_pd(out + i, _mm_div_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i)));
+        }
+        _DivideScalar(out + i, x + i, y + i, n - i);
+    }
+
+    void _NegateSSE2(double* out, const double* x, size_t n) {
+        const __m128d sign = _mm_set1_pd(-0.0);
+
+        size_t i = 0;
+        for (; i + 2 <= n; i += 2) {
+            _mm_storeu_pd(out + i, _mm_xor_pd(_mm_loadu_pd(x + i), sign));
+        }
+        _NegateScalar(out + i, x + i, n - i);
+    }
+
+    void _FillSSE2(double* out, double value, size_t n) {
+        const __m128d v = _mm_set1_pd(value);
+
+        size_t i = 0;
+        for (; i + 2 <= n; i += 2) {
+            _mm_storeu_pd(out + i, v);
+        }
+        _FillScalar(out + i, value, n - i);
+    }
+
+    void _AddFloatSSE2(float* out, const float* x, const float* y, size_t n) {
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(y + i)));
+        }
+        _AddScalar(out + i, x + i, y + i, n - i);
+    }
+
+    void _SubtractFloatSSE2(float* out, const float* x, const float* y, size_t n) {
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            _mm_storeu_ps(out + i, _mm_sub_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(y + i)));
+        }
+        _SubtractScalar(out + i, x + i, y + i, n - i);
+    }
+
+    void _MultiplyFloatSSE2(float* out, const float* x, const float* y, size_t n) {
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            _mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(y + i)));
+        }
+        _MultiplyScalar(out + i, x + i, y + i, n - i);
+    }
+
+    void _DivideFloatSSE2(float* out, const float* x, const float* y, size_t n) {
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            _mm_storeu_ps(out + i, _mm_div_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(y + i)));
+        }
+        _DivideScalar(out + i, x + i, y + i, n - i);
+    }
+
+    void _NegateFloatSSE2(float* out, const float* x, size_t n) {
+        const __m128 sign = _mm_set1_ps(-0.0f);
+
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            _mm_storeu_ps(out + i, _mm_xor_ps(_mm_loadu_ps(x + i), sign));
+        }
+        _NegateScalar(out + i, x + i, n - i);
+    }
+
+    void _FillFloatSSE2(float* out, float value, size_t n) {
+        const __m128 v = _mm_set1_ps(value);
+
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            _mm_storeu_ps(out + i, v);
+        }
+        _FillScalar(out + i, value, n - i);
+    }
+
+    // Accumulation of vector "x" to the lanes, NaN of "x" replaces the lane (as VectorKernels::Combine)
+
+    __m128d _SumSSE2(__m128d lane, __m128d x, __m128d) { return _mm_add_pd(lane, x); }
+
+    __m128d _MinSSE2(__m128d lane, __m128d x, __m128d) {
+        __m128d isNaN = _mm_cmpunord_pd(x, x);
+        return _mm_or_pd(_mm_and_pd(isNaN, x), _mm_andnot_pd(isNaN, _mm_min_pd(x, lane)));
+    }
+
+    __m128d _MaxSSE2(__m128d lane, __m128d x, __m128d) {
+        __m128d isNaN = _mm_cmpunord_pd(x, x);
+        return _mm_or_pd(_mm_and_pd(isNaN, x), _mm_andnot_pd(isNaN, _mm_max_pd(x, lane)));
+    }
+
+    __m128d _SquaredDeviationSSE2(__m128d lane, __m128d x, __m128d mean) {
+        __m128d deviation = _mm_sub_pd(x, mean);
+        return _mm_add_pd(lane, _mm_mul_pd(deviation, deviation));
+    }
+
+    __m128 _SumFloatSSE2(__m128 lane, __m128 x, __m128) { return _mm_add_ps(lane, x); }
+
+    __m128 _MinFloatSSE2(__m128 lane, __m128 x, __m128) {
+        __m128 isNaN = _mm_cmpunord_ps(x, x);
+        return _mm_or_ps(_mm_and_ps(isNaN, x), _mm_andnot_ps(isNaN, _mm_min_ps(x, lane)));
+    }
+
+    __m128 _MaxFloatSSE2(__m128 lane, __m128 x, __m128) {
+        __m128 isNaN = _mm_cmpunord_ps(x, x);
+        return _mm_or_ps(_mm_and_ps(isNaN, x), _mm_andnot_ps(isNaN, _mm_max_ps(x, lane)));
+    }
+
+    __m128 _SquaredDeviationFloatSSE2(__m128 lane, __m128 x, __m128 mean) {
+        __m128 deviation = _mm_sub_ps(x, mean);
+        return _mm_add_ps(lane, _mm_mul_ps(deviation, deviation));
+    }
+
+    // 8 lanes in 4 registers
+    template <__m128d(*Accumulate)(__m128d, __m128d, __m128d)>
+    double _AccumulateBlockSSE2(Reduction reduction, const double* x, size_t n, double mean) {
+        const __m128d m = _mm_set1_pd(mean);
+
+        __m128d lanes[4];
+        for (__m128d& lane : lanes) {
+            lane = _mm_set1_pd(core::VectorKernels::GetIdentity<double>(reduction));
+        }
+
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            lanes[0] = Accumulate(lanes[0], _mm_loadu_pd(x + i), m);
+            lanes[1] = Accumulate(lanes[1], _mm_loadu_pd(x + i + 2), m);
+            lanes[2] = Accumulate(lanes[2], _mm_loadu_pd(x + i + 4), m);
+            lanes[3] = Accumulate(lanes[3], _mm_loadu_pd(x + i + 6), m);
+        }
+
+        double values[8];
+        for (size_t j = 0; j < 4; ++j) {
+            _mm_storeu_pd(values + 2 * j, lanes[j]);
+        }
+        return _FinishBlock(reduction, values, x, i, n, mean);
+    }
+
+    // 8 lanes in 2 registers
+    template <__m128(*Accumulate)(__m128, __m128, __m128)>
+    float _AccumulateFloatBlockSSE2(Reduction reduction, const float* x, size_t n, float mean) {
+        const __m128 m = _mm_set1_ps(mean);
+
+        __m128 lanes[2];
+        for (__m128& lane : lanes) {
+            lane = _mm_set1_ps(core::VectorKernels::GetIdentity<float>(reduction));
+        }
+
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            lanes[0] = Accumulate(lanes[0], _mm_loadu_ps(x + i), m);
+            lanes[1] = Accumulate(lanes[1], _mm_loadu_ps(x + i + 4), m);
+        }
+
+        float values[8];
+        _mm_storeu_ps(values, lanes[0]);
+        _mm_storeu_ps(values + 4, lanes[1]);
+        return _FinishBlock(reduction, values, x, i, n, mean);
+    }
+
+    double _ReduceBlockSSE2(Reduction reduction, const double* x, size_t n, double mean) {
+        switch (reduction) {
+            case Reduction::SUM: return _AccumulateBlockSSE2<_SumSSE2>(reduction, x, n, mean);
+            case Reduction::MIN: return _AccumulateBlockSSE2<_MinSSE2>(reduction, x, n, mean);
+            case Reduction::MAX: return _AccumulateBlockSSE2<_MaxSSE2>(reduction, x, n, mean);
+            default:             return _AccumulateBlockSSE2<_SquaredDeviationSSE2>(reduction, x, n, mean);
+        }
+    }
+
+    float _ReduceFloatBlockSSE2(Reduction reduction, const float* x, size_t n, float mean) {
+        switch (reduction) {
+            case Reduction::SUM: return _AccumulateFloatBlockSSE2<_SumFloatSSE2>(reduction, x, n, mean);
+            case Reduction::MIN: return _AccumulateFloatBlockSSE2<_MinFloatSSE2>(reduction, x, n, mean);
+            case Reduction::MAX: return _AccumulateFloatBlockSSE2<_MaxFloatSSE2>(reduction, x, n, mean);
+            default:             return _AccumulateFloatBlockSSE2<_SquaredDeviationFloatSSE2>(reduction, x, n, mean);
+        }
+    }
+
+    double _ReduceSSE2(Reduction reduction, const double* x, size_t n, double mean) {
+        return _ReducePairwise<double>(reduction, x, n, mean, _ReduceBlockSSE2);
+    }
+
+    float _ReduceFloatSSE2(Reduction reduction, const float* x, size_t n, float mean) {
+        return _ReducePairwise<float>(reduction, x, n, mean, _ReduceFloatBlockSSE2);
+    }
+
+    // AVX2
+
+    #define PARSER_AVX2_TARGET __attribute__((target("avx2")))
+
+    PARSER_AVX2_TARGET void _AddAVX2(double* out, const double* x, const double* y, size_t n) {
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+        }
+        _AddScalar(out + i, x + i, y + i, n - i);
+    }
+
+    PARSER_AVX2_TARGET void _SubtractAVX2(double* out, const double* x, const double* y, size_t n) {
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            _mm256_storeu_pd(out + i, _mm256_sub_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+        }
+        _SubtractScalar(out + i, x + i, y + i, n - i);
+    }
+
+    PARSER_AVX2_TARGET void _MultiplyAVX2(double* out, const double* x, const double* y, size_t n) {
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+        }
+        _MultiplyScalar(out + i, x + i, y + i, n - i);
+    }
+
+    PARSER_AVX2_TARGET void _DivideAVX2(double* out, const double* x, const double* y, size_t n) {
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            _mm256_storeu_pd(out + i, _mm256_div_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+        }
+        _DivideScalar(out + i, x + i, y + i, n - i);
+    }
+
+    PARSER_AVX2_TARGET void _NegateAVX2(double* out, const double* x, size_t n) {
+        const __m256d sign = _mm256_set1_pd(-0.0);
+
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            _mm256_storeu_pd(out + i, _mm256_xor_pd(_mm256_loadu_pd(x + i), sign));
+        }
+        _NegateScalar(out + i, x + i, n - i);
+    }
+
+    PARSER_AVX2_TARGET void _FillAVX2(double* out, double value, size_t n) {
+        const __m256d v = _mm256_set1_pd(value);
+
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            _mm256_storeu_pd(out + i, v);
+        }
+        _FillScalar(out + i, value, n - i);
+    }
+
+    PARSER_AVX2_TARGET void _AddFloatAVX2(float* out, const float* x, const float* y, size_t n) {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+        }
+        _AddScalar(out + i, x + i, y + i, n - i);
+    }
+
+    PARSER_AVX2_TARGET void _SubtractFloatAVX2(float* out, const float* x, const float* y, size_t n) {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            _mm256_storeu_ps(out + i, _mm256_sub_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+        }
+        _SubtractScalar(out + i, x + i, y + i, n - i);
+    }
+
+    PARSER_AVX2_TARGET void _MultiplyFloatAVX2(float* out, const float* x, const float* y, size_t n) {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+        }
+        _MultiplyScalar(out + i, x + i, y + i, n - i);
+    }
+
+    PARSER_AVX2_TARGET void _DivideFloatAVX2(float* out, const float* x, const float* y, size_t n) {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            _mm256_storeu_ps(out + i, _mm256_div_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+        }
+        _DivideScalar(out + i, x + i, y + i, n - i);
+    }
+
+    PARSER_AVX2_TARGET void _NegateFloatAVX2(float* out, const float* x, size_t n) {
+        const __m256 sign = _mm256_set1_ps(-0.0f);
+
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            _mm256_storeu_ps(out + i, _mm256_xor_ps(_mm256_loadu_ps(x + i), sign));
+        }
+        _NegateScalar(out + i, x + i, n - i);
+    }
+
+    PARSER_AVX2_TARGET void _FillFloatAVX2(float* out, float value, size_t n) {
+        const __m256 v = _mm256_set1_ps(value);
+
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            _mm256_storeu_ps(out + i, v);
+        }
+        _FillScalar(out + i, value, n - i);
+    }
+
+    PARSER_AVX2_TARGET __m256d _SumAVX2(__m256d lane, __m256d x, __m256d) { return _mm256_add_pd(lane, x); }
+
+    PARSER_AVX2_TARGET __m256d _MinAVX2(__m256d lane, __m256d x, __m256d) {
+        return _mm256_blendv_pd(_mm256_min_pd(x, lane), x, _mm256_cmp_pd(x, x, _CMP_UNORD_Q));
+    }
+
+    PARSER_AVX2_TARGET __m256d _MaxAVX2(__m256d lane, __m256d x, __m256d) {
+        return _mm256_blendv_pd(_mm256_max_pd(x, lane), x, _mm256_cmp_pd(x, x, _CMP_UNORD_Q));
+    }
+
+    PARSER_AVX2_TARGET __m256d _SquaredDeviationAVX2(__m256d lane, __m256d x, __m256d mean) {
+        __m256d deviation = _mm256_sub_pd(x, mean);
+        return _mm256_add_pd(lane, _mm256_mul_pd(deviation, deviation));
+    }
+
+    PARSER_AVX2_TARGET __m256 _SumFloatAVX2(__m256 lane, __m256 x, __m256) { return _mm256_add_ps(lane, x); }
+
+    PARSER_AVX2_TARGET __m256 _MinFloatAVX2(__m256 lane, __m256 x, __m256) {
+        return _mm256_blendv_ps(_mm256_min_ps(x, lane), x, _mm256_cmp_ps(x, x, _CMP_UNORD_Q));
+    }
+
+    PARSER_AVX2_TARGET __m256 _MaxFloatAVX2(__m256 lane, __m256 x, __m256) {
+        return _mm256_blendv_ps(_mm256_max_ps(x, lane), x, _mm256_cmp_ps(x, x, _CMP_UNORD_Q));
+    }
+
+    PARSER_AVX2_TARGET __m256 _SquaredDeviationFloatAVX2(__m256 lane, __m256 x, __m256 mean) {
+        __m256 deviation = _mm256_sub_ps(x, mean);
+        return _mm256_add_ps(lane, _mm256_mul_ps(deviation, deviation));
+    }
+
+    // 8 lanes in 2 registers
+    template <__m256d(*Accumulate)(__m256d, __m256d, __m256d)>
+    PARSER_AVX2_TARGET double _AccumulateBlockAVX2(Reduction reduction, const double* x, size_t n, double mean) {
+        const __m256d m = _mm256_set1_pd(mean);
+
+        __m256d lanes[2];
+        for (__m256d& lane : lanes) {
+            lane = _mm256_set1_pd(core::VectorKernels::GetIdentity<double>(reduction));
+        }
+
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            lanes[0] = Accumulate(lanes[0], _mm256_loadu_pd(x + i), m);
+            lanes[1] = Accumulate(lanes[1], _mm256_loadu_pd(x + i + 4), m);
+        }
+
+        double values[8];
+        _mm256_storeu_pd(values, lanes[0]);
+        _mm256_storeu_pd(values + 4, lanes[1]);
+        return _FinishBlock(reduction, values, x, i, n, mean);
+    }
+
+    // 8 lanes in 1 register
+    template <__m256(*Accumulate)(__m256, __m256, __m256)>
+    PARSER_AVX2_TARGET float _AccumulateFloatBlockAVX2(Reduction reduction, const float* x, size_t n, float mean) {
+        const __m256 m = _mm256_set1_ps(mean);
+
+        __m256 lane = _mm256_set1_ps(core::VectorKernels::GetIdentity<float>(reduction));
+
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            lane = Accumulate(lane, _mm256_loadu_ps(x + i), m);
+        }
+
+        float values[8];
+        _mm256_storeu_ps(values, lane);
+        return _FinishBlock(reduction, values, x, i, n, mean);
+    }
+
+    double _ReduceBlockAVX2(Reduction reduction, const double* x, size_t n, double mean) {
+        switch (reduction) {
+            case Reduction::SUM: return _AccumulateBlockAVX2<_SumAVX2>(reduction, x, n, mean);
+            case Reduction::MIN: return _AccumulateBlockAVX2<_MinAVX2>(reduction, x, n, mean);
+            case Reduction::MAX: return _AccumulateBlockAVX2<_MaxAVX2>(reduction, x, n, mean);
+            default:             return _AccumulateBlockAVX2<_SquaredDeviationAVX2>(reduction, x, n, mean);
+        }
+    }
+
+    float _ReduceFloatBlockAVX2(Reduction reduction, const float* x, size_t n, float mean) {
+        switch (reduction) {
+            case Reduction::SUM: return _AccumulateFloatBlockAVX2<_SumFloatAVX2>(reduction, x, n, mean);
+            case Reduction::MIN: return _AccumulateFloatBlockAVX2<_MinFloatAVX2>(reduction, x, n, mean);
+            case Reduction::MAX: return _AccumulateFloatBlockAVX2<_MaxFloatAVX2>(reduction, x, n, mean);
+            default:             return _AccumulateFloatBlockAVX2<_SquaredDeviationFloatAVX2>(reduction, x, n, mean);
+        }
+    }
+
+    double _ReduceAVX2(Reduction reduction, const double* x, size_t n, double mean) {
+        return _ReducePairwise<double>(reduction, x, n, mean, _ReduceBlockAVX2);
+    }
+
+    float _ReduceFloatAVX2(Reduction reduction, const float* x, size_t n, float mean) {
+        return _ReducePairwise<float>(reduction, x, n, mean, _ReduceFloatBlockAVX2);
+    }
+#endif
+
+    const core::VectorKernels s_ScalarKernels = {
+        core::VectorKernels::Level::SCALAR,
+        _AddScalar<double>, _SubtractScalar<double>, _MultiplyScalar<double>, _DivideScalar<double>,
+        _NegateScalar<double>, _FillScalar<double>,
+        _AddScalar<float>, _SubtractScalar<float>, _MultiplyScalar<float>, _DivideScalar<float>,
+        _NegateScalar<float>, _FillScalar<float>,
+        _ReduceScalar<double>, _ReduceScalar<float>
+    };
+
+#if PARSER_VECTOR_KERNELS_X86
+    const core::VectorKernels s_SSE2Kernels = {
+        core::VectorKernels::Level::SSE2,
+        _AddSSE2, _SubtractSSE2, _MultiplySSE2, _DivideSSE2, _NegateSSE2, _FillSSE2,
+        _AddFloatSSE2, _SubtractFloatSSE2, _MultiplyFloatSSE2, _DivideFloatSSE2, _NegateFloatSSE2, _FillFloatSSE2,
+        _ReduceSSE2, _ReduceFloatSSE2
+    };
+
+    const core::VectorKernels s_AVX2Kernels = {
+        core::VectorKernels::Level::AVX2,
+        _AddAVX2, _SubtractAVX2, _MultiplyAVX2, _DivideAVX2, _NegateAVX2, _FillAVX2,
+        _AddFloatAVX2, _SubtractFloatAVX2, _MultiplyFloatAVX2, _DivideFloatAVX2, _NegateFloatAVX2, _FillFloatAVX2,
+        _ReduceAVX2, _ReduceFloatAVX2
+    };
+#endif
+}
+
+core::VectorKernels::Level core::VectorKernels::GetSupportedLevel() noexcept {
+#if PARSER_VECTOR_KERNELS_X86
+    static const Level s_level = __builtin_cpu_supports("avx2") ? Level::AVX2 : Level::SSE2;
+    return s_level;
+#else
+    return Level::SCALAR;
+#endif
+}
+
+const core::VectorKernels& core::VectorKernels::Get() noexcept {
+    return Get(GetSupportedLevel());
+}
+
+const core::VectorKernels& core::VectorKernels::Get(Level level) noexcept {
+    Level supported = GetSupportedLevel();
+    if (level > supported) {
+        level = supported;
+    }
+
+#if PARSER_VECTOR_KERNELS_X86
+    switch (level) {
+        case Level::AVX2: return s_AVX2Kernels;
+        case Level::SSE2: return s_SSE2Kernels;
+        default: break;
+    }
+#endif
+    return s_ScalarKernels;
+}
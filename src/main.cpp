@@ -1,9 +1,145 @@
 #include <iostream>
+#include <cstdio>
 #include <cstring>
+#include <charconv>
+#include <chrono>
 
 #include <parser/parser.h>
 
-int main() {
+namespace {
+    // Size of the input block, lines are never split between blocks
+    constexpr size_t s_BlockSize = 16 << 20;
+
+    // Count of lines evaluated and formatted by one task
+    constexpr size_t s_ChunkSize = 1024;
+
+    // Evaluate every line of "input" and write "<value>" or "error <code>" line for it to "output"
+    bool EvaluateStream(const core::Parser<>& parser, FILE* input, FILE* output, size_t& expressionCount) {
+        // one extra byte for the terminator of the last line
+        std::vector<char> block(s_BlockSize + 1);
+        size_t            blockUsed = 0;
+
+        std::vector<const char*> lines;
+        std::vector<std::string> chunks;
+
+        bool isEnd = false;
+        while (!isEnd) {
+            if (blockUsed == block.size() - 1) { // line longer than block
+                block.resize(block.size() * 2);
+            }
+            blockUsed += fread(block.data() + blockUsed, 1, block.size() - 1 - blockUsed, input);
+            if (ferror(input)) {
+                return false;
+            }
+            isEnd = feof(input);
+
+            // Complete lines are terminated in place, the tail is moved to the next block
+            char*  data      = block.data();
+            size_t lineBegin = 0;
+            lines.clear();
+
+            while (true) {
+                char* newline = static_cast<char*>(memchr(data + lineBegin, '\n', blockUsed - lineBegin));
+                if (!newline) {
+                    if (isEnd && lineBegin < blockUsed) {
+                        data[blockUsed] = '\0';
+                        lines.push_back(data + lineBegin);
+                        lineBegin = blockUsed;
+                    }
+                    break;
+                }
+
+                size_t lineEnd = newline - data;
+                if (lineEnd > lineBegin && data[lineEnd - 1] == '\r') {
+                    data[lineEnd - 1] = '\0';
+                }
+                *newline = '\0';
+
+                lines.push_back(data + lineBegin);
+                lineBegin = lineEnd + 1;
+            }
+
+            size_t chunkCount = (lines.size() + s_ChunkSize - 1) / s_ChunkSize;
+            if (chunks.size() < chunkCount) {
+                chunks.resize(chunkCount);
+            }
+
+            core::ThreadPool::GetDefault().ParallelFor(chunkCount, 1, [&](size_t begin, size_t end) {
+                char number[64];
+
+                for (size_t chunk = begin; chunk < end; ++chunk) {
+                    std::string& text = chunks[chunk];
+                    text.clear();
+
+                    size_t last = std::min(lines.size(), (chunk + 1) * s_ChunkSize);
+                    for (size_t i = chunk * s_ChunkSize; i < last; ++i) {
+                        auto result = parser.Evaluate(lines[i]);
+                        if (result.HasValue()) {
+                            text.append(number, std::to_chars(number, number + sizeof(number), result.Get()).ptr);
+                        }
+                        else {
+                            text.append("error ");
+                            text.append(number, std::to_chars(number, number + sizeof(number), (int)result.Error().code).ptr);
+                        }
+                        text.push_back('\n');
+                    }
+                }
+            });
+
+            for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+                if (fwrite(chunks[chunk].data(), 1, chunks[chunk].size(), output) != chunks[chunk].size()) {
+                    return false;
+                }
+            }
+            expressionCount += lines.size();
+
+            blockUsed -= lineBegin;
+            memmove(data, data + lineBegin, blockUsed);
+        }
+
+        return fflush(output) == 0;
+    }
+
+    int RunBulk(const char* inputPath, const char* outputPath) {
+        FILE* input  = strcmp(inputPath, "-") == 0 ? stdin : fopen(inputPath, "rb");
+        FILE* output = outputPath ? fopen(outputPath, "wb") : stdout;
+        if (!input || !output) {
+            std::cerr << "Can't open " << (!input ? inputPath : outputPath) << "\n";
+            return 1;
+        }
+        static char s_OutputBuffer[1 << 20];
+        setvbuf(output, s_OutputBuffer, _IOFBF, sizeof(s_OutputBuffer));
+
+        core::Parser parser;
+        size_t       expressionCount = 0;
+
+        auto start   = std::chrono::steady_clock::now();
+        bool success = EvaluateStream(parser, input, output, expressionCount);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (input != stdin) {
+            fclose(input);
+        }
+        if (output != stdout) {
+            success = fclose(output) == 0 && success;
+        }
+
+        if (!success) {
+            std::cerr << "I/O error\n";
+            return 1;
+        }
+        std::cerr << expressionCount << " expressions in " << seconds << " s ("
+            << (seconds > 0 ? expressionCount / seconds : 0) << " expressions/s)\n";
+        return 0;
+    }
+}
+
+int main(int argc, char** argv) {
+    // parser --bulk <input file or -> [output file]
+    if (argc >= 3 && strcmp(argv[1], "--bulk") == 0) {
+        return RunBulk(argv[2], argc >= 4 ? argv[3] : nullptr);
+    }
+
     core::Parser parser;
 
     std::string command;
@@ -22,7 +158,8 @@ int main() {
                 std::cout << "Result: " << result.Get() << "\n\n";
             }
             else {
-                std::cout << "Expression is invalid (code: " << (int)result.Error() << ")\n\n";
+                std::cout << "Expression is invalid (code: " << (int)result.Error().code
+                    << ", offset: " << result.Error().offset << ")\n\n";
             }
         }
         else {
@@ -31,6 +168,6 @@ int main() {
 
         command.clear();
     }
-    
+
     return 0;
-}
\ No newline at end of file
+}
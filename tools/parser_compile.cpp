@@ -0,0 +1,103 @@
+#include <cstdio>
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <parser/parser.h>
+#include <parser/expression_file.h>
+
+// parser_compile <formula file> <output file> [variable names...]
+// Compile every line of the formula file into expression file, variable slots are in order of the names
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: parser_compile <formula file> <output file> [variable names...]\n");
+        return 1;
+    }
+
+    core::Parser<> parser;
+
+    std::vector<std::string_view> variableNames;
+    for (int i = 3; i < argc; ++i) {
+        size_t slot = parser.DeclareVariable(argv[i]);
+        if (slot == variableNames.size()) {
+            variableNames.emplace_back(argv[i]);
+        }
+    }
+
+    FILE* input = fopen(argv[1], "rb");
+    if (!input) {
+        fprintf(stderr, "Can't open %s\n", argv[1]);
+        return 1;
+    }
+
+    std::string text;
+    char        block[1 << 16];
+    for (size_t size; (size = fread(block, 1, sizeof(block), input)) > 0;) {
+        text.append(block, size);
+    }
+    fclose(input);
+
+    std::vector<std::string>                        sources;
+    std::vector<core::Parser<>::CompiledExpression> compiled;
+    size_t                                          errorCount = 0;
+
+    // one expression per line, the last line may be unterminated
+    for (size_t begin = 0; begin < text.size();) {
+        size_t end = std::min(text.find('\n', begin), text.size());
+
+        std::string line = text.substr(begin, end - begin);
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        begin = end + 1;
+
+        auto result = parser.Compile(line.c_str());
+        if (result.HasValue()) {
+            compiled.emplace_back(result.Get());
+        }
+        else {
+            fprintf(
+                stderr, "line %zu, column %u: error %d\n",
+                sources.size() + 1, result.Error().offset + 1, (int)result.Error().code
+            );
+            ++errorCount;
+        }
+        sources.emplace_back(std::move(line));
+    }
+
+    if (errorCount > 0) {
+        fprintf(stderr, "%zu invalid expressions, nothing is written\n", errorCount);
+        return 1;
+    }
+
+    std::vector<core::ExpressionFile::Expression> expressions(compiled.size());
+    for (size_t i = 0; i < compiled.size(); ++i) {
+        core::ExpressionFile::Expression& expression = expressions[i];
+
+        expression.code          = compiled[i].GetCode().data();
+        expression.constants     = compiled[i].GetConstants().data();
+        expression.codeSize      = (uint32_t)compiled[i].GetCode().size();
+        expression.constantCount = (uint32_t)compiled[i].GetConstants().size();
+        expression.stackSize     = (uint32_t)compiled[i].GetStackSize();
+        expression.variableCount = (uint32_t)compiled[i].GetVariableCount();
+        expression.source        = sources[i];
+    }
+
+    core::ExpressionFile::Error error = core::ExpressionFile::Write(
+        argv[2], expressions.data(), expressions.size(), variableNames.data(), variableNames.size()
+    );
+
+    // Written file must load back
+    core::ExpressionFile file;
+    if (error == core::ExpressionFile::Error::NONE) {
+        error = file.Open(argv[2]);
+    }
+    if (error != core::ExpressionFile::Error::NONE) {
+        fprintf(stderr, "Can't write %s (error %d)\n", argv[2], (int)error);
+        return 1;
+    }
+
+    fprintf(stderr, "%zu expressions written to %s\n", file.GetExpressionCount(), argv[2]);
+    return 0;
+}